@@ -34,6 +34,12 @@ const ranConfigSchema = new mongoose.Schema(
       latency: {
         type: Number,
         description: 'Latency in seconds'
+      },
+      latencyPercentiles: {
+        p50: { type: Number, description: 'Median one-way delay in seconds' },
+        p90: { type: Number, description: '90th percentile one-way delay in seconds' },
+        p99: { type: Number, description: '99th percentile one-way delay in seconds' },
+        p999: { type: Number, description: '99.9th percentile one-way delay in seconds' }
       }
     }
   },
@@ -0,0 +1,18 @@
+{
+  "targets": [
+    {
+      "target_name": "nr_analytic",
+      "sources": ["nr-analytic-addon.cc"],
+      "include_dirs": ["../ns3"],
+      "defines": ["NAPI_VERSION=8"],
+      "cflags_cc": ["-std=c++17", "-O3"],
+      "xcode_settings": {
+        "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+        "OTHER_CPLUSPLUSFLAGS": ["-O3"]
+      },
+      "conditions": [
+        ["OS=='linux'", {"libraries": ["-lrt"]}]
+      ]
+    }
+  ]
+}
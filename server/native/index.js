@@ -0,0 +1,14 @@
+/**
+ * Loader for the optional native analytic model addon
+ * Exports null when the addon has not been built (`npm run build:native`),
+ * in which case callers fall back to the JavaScript model.
+ */
+let addon = null;
+
+try {
+  addon = require("./build/Release/nr_analytic.node");
+} catch (error) {
+  addon = null;
+}
+
+module.exports = addon;
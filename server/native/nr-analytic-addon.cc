@@ -0,0 +1,316 @@
+/*
+ * Node-API addon that gives the portal the closed-form model from
+ * server/ns3/nr-sim-analytic.h in-process.
+ *
+ *   evaluate({frequency, bandwidth, duplexMode, transmitPower})
+ *     -> {frequency, bandwidth, duplexMode, transmitPower,
+ *         results: {throughput, latency}}
+ *   evaluateBatch({frequency, bandwidth, transmitPower: Float64Array,
+ *                  tdd: Uint8Array})
+ *     -> Promise<{throughput: Float64Array, latency: Float64Array}>
+ *
+ *   mapSharedResult(name)
+ *     -> ArrayBuffer | null
+ *
+ * Batches of kAsyncThreshold rows or more are evaluated on the libuv thread
+ * pool so the event loop keeps serving requests; their input arrays must not
+ * be modified until the promise settles.
+ *
+ * mapSharedResult maps a segment published by `nr-simulation --shmName`
+ * (layout in server/ns3/nr-sim-shm-result.h) and unlinks its name. The
+ * ArrayBuffer points at the mapping itself, copy-on-write, and unmaps it
+ * when collected. null means the segment is missing or incomplete.
+ */
+
+#include <node_api.h>
+#include "nr-sim-analytic.h"
+#include "nr-sim-shm-result.h"
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+namespace {
+
+const size_t kAsyncThreshold = 16384;
+
+// Bail out of a napi_value function when a Node-API call fails; the pending
+// exception (if any) propagates to JavaScript
+#define NAPI_CALL(env, call)                                    \
+  do {                                                          \
+    if ((call) != napi_ok) {                                    \
+      ThrowLastError(env);                                      \
+      return nullptr;                                           \
+    }                                                           \
+  } while (0)
+
+void ThrowLastError(napi_env env) {
+  bool pending = false;
+  napi_is_exception_pending(env, &pending);
+  if (!pending) {
+    const napi_extended_error_info* info = nullptr;
+    napi_get_last_error_info(env, &info);
+    napi_throw_error(env, nullptr, info && info->error_message ? info->error_message : "Node-API call failed");
+  }
+}
+
+// A batch in flight on the thread pool, with references that keep its
+// typed arrays alive until it completes
+struct BatchWork {
+  AnalyticBatch batch;
+  napi_async_work work = nullptr;
+  napi_deferred deferred = nullptr;
+  napi_ref result = nullptr;
+  napi_ref inputs[4] = {};
+};
+
+bool GetTypedArray(napi_env env, napi_value object, const char* key, napi_typedarray_type expected,
+                   napi_value& array, void*& data, size_t& length) {
+  bool isTypedArray = false;
+  napi_typedarray_type type;
+  if (napi_get_named_property(env, object, key, &array) != napi_ok ||
+      napi_is_typedarray(env, array, &isTypedArray) != napi_ok || !isTypedArray ||
+      napi_get_typedarray_info(env, array, &type, &length, &data, nullptr, nullptr) != napi_ok ||
+      type != expected) {
+    std::string message = std::string(key) +
+                          (expected == napi_uint8_array ? " must be a Uint8Array" : " must be a Float64Array");
+    napi_throw_type_error(env, nullptr, message.c_str());
+    return false;
+  }
+  return true;
+}
+
+napi_value CreateFloat64Array(napi_env env, size_t length, double*& data) {
+  napi_value buffer;
+  napi_value array;
+  void* raw = nullptr;
+  NAPI_CALL(env, napi_create_arraybuffer(env, length * sizeof(double), &raw, &buffer));
+  NAPI_CALL(env, napi_create_typedarray(env, napi_float64_array, length, buffer, 0, &array));
+  data = static_cast<double*>(raw);
+  return array;
+}
+
+// evaluate(config): one configuration, same shape as calculateSimulationResults
+napi_value Evaluate(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value config;
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, &config, nullptr, nullptr));
+  napi_valuetype kind = napi_undefined;
+  if (argc < 1 || napi_typeof(env, config, &kind) != napi_ok || kind != napi_object) {
+    napi_throw_type_error(env, nullptr, "evaluate expects a configuration object");
+    return nullptr;
+  }
+
+  napi_value frequency, bandwidth, duplexMode, transmitPower;
+  NAPI_CALL(env, napi_get_named_property(env, config, "frequency", &frequency));
+  NAPI_CALL(env, napi_get_named_property(env, config, "bandwidth", &bandwidth));
+  NAPI_CALL(env, napi_get_named_property(env, config, "duplexMode", &duplexMode));
+  NAPI_CALL(env, napi_get_named_property(env, config, "transmitPower", &transmitPower));
+
+  // Coerce like the JavaScript model's arithmetic does
+  napi_value number;
+  double f = 0, bw = 0, power = 0;
+  NAPI_CALL(env, napi_coerce_to_number(env, frequency, &number));
+  NAPI_CALL(env, napi_get_value_double(env, number, &f));
+  NAPI_CALL(env, napi_coerce_to_number(env, bandwidth, &number));
+  NAPI_CALL(env, napi_get_value_double(env, number, &bw));
+  NAPI_CALL(env, napi_coerce_to_number(env, transmitPower, &number));
+  NAPI_CALL(env, napi_get_value_double(env, number, &power));
+  char mode[8] = "";
+  napi_valuetype modeKind = napi_undefined;
+  NAPI_CALL(env, napi_typeof(env, duplexMode, &modeKind));
+  if (modeKind == napi_string) {
+    NAPI_CALL(env, napi_get_value_string_utf8(env, duplexMode, mode, sizeof(mode), nullptr));
+  }
+
+  double throughput = 0;
+  double latency = 0;
+  AnalyticEvaluate(f, bw, std::strcmp(mode, "TDD") == 0, power, throughput, latency);
+
+  napi_value result, results, value;
+  NAPI_CALL(env, napi_create_object(env, &result));
+  NAPI_CALL(env, napi_set_named_property(env, result, "frequency", frequency));
+  NAPI_CALL(env, napi_set_named_property(env, result, "bandwidth", bandwidth));
+  NAPI_CALL(env, napi_set_named_property(env, result, "duplexMode", duplexMode));
+  NAPI_CALL(env, napi_set_named_property(env, result, "transmitPower", transmitPower));
+  NAPI_CALL(env, napi_create_object(env, &results));
+  NAPI_CALL(env, napi_create_double(env, throughput, &value));
+  NAPI_CALL(env, napi_set_named_property(env, results, "throughput", value));
+  NAPI_CALL(env, napi_create_double(env, latency, &value));
+  NAPI_CALL(env, napi_set_named_property(env, results, "latency", value));
+  NAPI_CALL(env, napi_set_named_property(env, result, "results", results));
+  return result;
+}
+
+// Release a batch's references and async work, whichever were created
+void DeleteBatchWork(napi_env env, BatchWork* work) {
+  if (work->result != nullptr) {
+    napi_delete_reference(env, work->result);
+  }
+  for (napi_ref ref : work->inputs) {
+    if (ref != nullptr) {
+      napi_delete_reference(env, ref);
+    }
+  }
+  if (work->work != nullptr) {
+    napi_delete_async_work(env, work->work);
+  }
+  delete work;
+}
+
+void ExecuteBatch(napi_env /*env*/, void* data) {
+  AnalyticEvaluateBatch(static_cast<BatchWork*>(data)->batch);
+}
+
+void CompleteBatch(napi_env env, napi_status status, void* data) {
+  BatchWork* work = static_cast<BatchWork*>(data);
+  napi_value result;
+  if (status == napi_ok && napi_get_reference_value(env, work->result, &result) == napi_ok) {
+    napi_resolve_deferred(env, work->deferred, result);
+  } else {
+    napi_value message, error;
+    napi_create_string_utf8(env, "Analytic batch was cancelled", NAPI_AUTO_LENGTH, &message);
+    napi_create_error(env, nullptr, message, &error);
+    napi_reject_deferred(env, work->deferred, error);
+  }
+  DeleteBatchWork(env, work);
+}
+
+// evaluateBatch(arrays): structure-of-arrays batch, resolved with new arrays
+napi_value EvaluateBatch(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value arrays;
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, &arrays, nullptr, nullptr));
+  napi_valuetype kind = napi_undefined;
+  if (argc < 1 || napi_typeof(env, arrays, &kind) != napi_ok || kind != napi_object) {
+    napi_throw_type_error(env, nullptr, "evaluateBatch expects {frequency, bandwidth, transmitPower, tdd}");
+    return nullptr;
+  }
+
+  static const char* keys[4] = {"frequency", "bandwidth", "transmitPower", "tdd"};
+  napi_value inputs[4];
+  void* data[4];
+  size_t length[4];
+  for (int i = 0; i < 4; i++) {
+    if (!GetTypedArray(env, arrays, keys[i], i == 3 ? napi_uint8_array : napi_float64_array,
+                       inputs[i], data[i], length[i])) {
+      return nullptr;
+    }
+  }
+  if (length[1] != length[0] || length[2] != length[0] || length[3] != length[0]) {
+    napi_throw_range_error(env, nullptr, "evaluateBatch arrays must all have the same length");
+    return nullptr;
+  }
+
+  AnalyticBatch batch;
+  batch.n = length[0];
+  batch.frequency = static_cast<const double*>(data[0]);
+  batch.bandwidth = static_cast<const double*>(data[1]);
+  batch.txPower = static_cast<const double*>(data[2]);
+  batch.tdd = static_cast<const uint8_t*>(data[3]);
+  napi_value result, throughput, latency;
+  NAPI_CALL(env, napi_create_object(env, &result));
+  throughput = CreateFloat64Array(env, batch.n, batch.throughput);
+  if (throughput == nullptr) {
+    return nullptr;
+  }
+  latency = CreateFloat64Array(env, batch.n, batch.latency);
+  if (latency == nullptr) {
+    return nullptr;
+  }
+  NAPI_CALL(env, napi_set_named_property(env, result, "throughput", throughput));
+  NAPI_CALL(env, napi_set_named_property(env, result, "latency", latency));
+
+  napi_value promise;
+  napi_deferred deferred;
+  NAPI_CALL(env, napi_create_promise(env, &deferred, &promise));
+  if (batch.n < kAsyncThreshold) {
+    AnalyticEvaluateBatch(batch);
+    NAPI_CALL(env, napi_resolve_deferred(env, deferred, result));
+    return promise;
+  }
+
+  BatchWork* work = new BatchWork;
+  work->batch = batch;
+  work->deferred = deferred;
+  napi_value name;
+  bool ok = napi_create_reference(env, result, 1, &work->result) == napi_ok &&
+            napi_create_string_utf8(env, "nrAnalyticBatch", NAPI_AUTO_LENGTH, &name) == napi_ok;
+  for (int i = 0; ok && i < 4; i++) {
+    ok = napi_create_reference(env, inputs[i], 1, &work->inputs[i]) == napi_ok;
+  }
+  ok = ok && napi_create_async_work(env, nullptr, name, ExecuteBatch, CompleteBatch, work, &work->work) == napi_ok &&
+       napi_queue_async_work(env, work->work) == napi_ok;
+  if (!ok) {
+    // Throw first: the cleanup calls would overwrite the last error info
+    ThrowLastError(env);
+    DeleteBatchWork(env, work);
+    return nullptr;
+  }
+  return promise;
+}
+
+void UnmapSharedResult(napi_env /*env*/, void* data, void* size) {
+  munmap(data, reinterpret_cast<size_t>(size));
+}
+
+// mapSharedResult(name): the published result segment as an ArrayBuffer
+napi_value MapSharedResult(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value arg;
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, &arg, nullptr, nullptr));
+  char name[256] = "";
+  size_t length = 0;
+  if (argc < 1 || napi_get_value_string_utf8(env, arg, name, sizeof(name), &length) != napi_ok ||
+      length + 1 >= sizeof(name)) {
+    napi_throw_type_error(env, nullptr, "mapSharedResult expects a shared memory object name");
+    return nullptr;
+  }
+
+  napi_value result;
+  NAPI_CALL(env, napi_get_null(env, &result));
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return result;
+  }
+  shm_unlink(name);
+  struct stat st;
+  void* mapped = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    mapped = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return result;
+  }
+  size_t size = st.st_size;
+  if (!SharedResult::Validate(mapped, size)) {
+    munmap(mapped, size);
+    return result;
+  }
+  if (napi_create_external_arraybuffer(env, mapped, size, UnmapSharedResult, reinterpret_cast<void*>(size),
+                                       &result) != napi_ok) {
+    munmap(mapped, size);
+    ThrowLastError(env);
+    return nullptr;
+  }
+  return result;
+}
+
+napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+    {"evaluate", nullptr, Evaluate, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+    {"evaluateBatch", nullptr, EvaluateBatch, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+    {"mapSharedResult", nullptr, MapSharedResult, nullptr, nullptr, nullptr, napi_enumerable, nullptr},
+  };
+  NAPI_CALL(env, napi_define_properties(env, exports, 3, properties));
+  return exports;
+}
+
+} // namespace
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
@@ -0,0 +1,142 @@
+#!/usr/bin/env bash
+#
+# Build a static, LTO, profile-guided nr-simulation (see CMakeLists.txt).
+#
+#   build-optimized.sh [all|instrument|train|final|compare]
+#
+# instrument  static ns-3 + nr and nr-simulation built with -fprofile-generate
+# train       run the instrumented binary over the TRAIN_SCENARIOS bench set
+# final       rebuild ns-3 + nr and nr-simulation with the collected profile
+# compare     bench the scratch build (default profile, ./ns3 wrapper) against
+#             the optimized binary: startup time, events/s, wall time per
+#             simulated second and peak RSS
+#
+# ns-3 and nr are rebuilt in the same directories for both PGO phases so
+# GCC finds each object's profile under the same path. Nothing under
+# $NS3_DIR/build (the scratch build) is touched.
+
+set -euo pipefail
+
+NS3_DIR=${NS3_DIR:-$HOME/ns-3.43}
+WORK_DIR=${WORK_DIR:-$NS3_DIR/nr-sim-optimized}
+JOBS=${JOBS:-$(nproc)}
+CXX=${CXX:-c++}
+TRAIN_SCENARIOS=${TRAIN_SCENARIOS:-"single-link base ues-60 saturating fdd mu-3 ues-294-endpoint"}
+DEFAULT_SIMULATOR=${DEFAULT_SIMULATOR:-$NS3_DIR/build/scratch/ns3.43-nr-simulation-default}
+MPI=${MPI:-OFF}
+
+SRC_DIR=$(cd "$(dirname "$0")" && pwd)
+PGO_DIR=$WORK_DIR/pgo
+NS3_OUT=$WORK_DIR/ns3
+NR_SIM_BUILD=$WORK_DIR/nr-sim
+
+if "$CXX" --version | grep -q clang; then
+  CLANG=1
+else
+  CLANG=0
+fi
+
+# Flags for every ns-3, nr and nr-simulation object in a PGO phase
+pgo_flags() {
+  case "$1" in
+    generate) echo "-fprofile-generate=$PGO_DIR" ;;
+    use)
+      if [ "$CLANG" = 1 ]; then
+        echo "-fprofile-use=$PGO_DIR/default.profdata -Wno-profile-instr-unprofiled"
+      else
+        echo "-fprofile-use=$PGO_DIR -fprofile-partial-training -Wno-missing-profile"
+      fi
+      ;;
+  esac
+}
+
+# Static, optimized, LTO ns-3 with contrib/nr, then nr-simulation against it
+build() {
+  local phase=$1
+  local flags
+  flags=$(pgo_flags "$phase")
+  cmake -S "$NS3_DIR" -B "$WORK_DIR/ns3-cmake" \
+    -DCMAKE_CXX_COMPILER="$CXX" \
+    -DCMAKE_BUILD_TYPE=release \
+    -DCMAKE_CXX_FLAGS="$flags" \
+    -DNS3_OUTPUT_DIRECTORY="$NS3_OUT" \
+    -DNS3_STATIC=ON \
+    -DNS3_LINK_TIME_OPTIMIZATION=ON \
+    -DNS3_NATIVE_OPTIMIZATIONS=OFF \
+    -DNS3_EXAMPLES=OFF \
+    -DNS3_TESTS=OFF \
+    -DNS3_WARNINGS_AS_ERRORS=OFF \
+    -DNS3_MPI="$MPI"
+  cmake --build "$WORK_DIR/ns3-cmake" -j "$JOBS"
+
+  cmake -S "$SRC_DIR" -B "$NR_SIM_BUILD" \
+    -DCMAKE_CXX_COMPILER="$CXX" \
+    -DNS3_OUTPUT_DIR="$NS3_OUT" \
+    -DNR_SIM_PGO="$phase" \
+    -DNR_SIM_PGO_DIR="$PGO_DIR" \
+    -DNR_SIM_MPI="$MPI"
+  cmake --build "$NR_SIM_BUILD" -j "$JOBS"
+}
+
+instrument() {
+  rm -rf "$PGO_DIR"
+  mkdir -p "$PGO_DIR"
+  build generate
+}
+
+train() {
+  for scenario in $TRAIN_SCENARIOS; do
+    "$NR_SIM_BUILD/nr-simulation-bench" --simulator="$NR_SIM_BUILD/nr-simulation" \
+      --filter="$scenario" --repeat=1 --outputPath="$WORK_DIR/train-$scenario.json"
+  done
+  if [ "$CLANG" = 1 ]; then
+    llvm-profdata merge -o "$PGO_DIR/default.profdata" "$PGO_DIR"/*.profraw
+  fi
+}
+
+final() {
+  build use
+  echo "Optimized binary: $NR_SIM_BUILD/nr-simulation"
+}
+
+# Wall time of one short run, in seconds
+time_run() {
+  local start end
+  start=$(date +%s.%N)
+  "$@" >/dev/null 2>&1
+  end=$(date +%s.%N)
+  awk -v s="$start" -v e="$end" 'BEGIN { printf "%.3f", e - s }'
+}
+
+compare() {
+  local out
+  out=$(mktemp /tmp/nr-sim-compare-XXXXXX.json)
+  local args="--maxSimTime=0.01 --outputPath=$out"
+  local wrapper direct
+  wrapper=$(cd "$NS3_DIR" && time_run ./ns3 run "nr-simulation $args")
+  direct=$(time_run "$NR_SIM_BUILD/nr-simulation" $args)
+  rm -f "$out"
+  echo "Startup incl. launcher: ./ns3 run $wrapper s, standalone $direct s"
+
+  "$NR_SIM_BUILD/nr-simulation-bench" --simulator="$DEFAULT_SIMULATOR" \
+    --outputPath="$WORK_DIR/bench-default.json"
+  "$NR_SIM_BUILD/nr-simulation-bench" --simulator="$NR_SIM_BUILD/nr-simulation" \
+    --baseline="$WORK_DIR/bench-default.json" --outputPath="$WORK_DIR/bench-optimized.json"
+}
+
+case "${1:-all}" in
+  instrument) instrument ;;
+  train) train ;;
+  final) final ;;
+  compare) compare ;;
+  all)
+    instrument
+    train
+    final
+    compare
+    ;;
+  *)
+    echo "usage: $0 [all|instrument|train|final|compare]" >&2
+    exit 2
+    ;;
+esac
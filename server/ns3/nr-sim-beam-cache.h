@@ -0,0 +1,248 @@
+/*
+ * Persistent beam pairs for ideal beamforming.
+ *
+ * CachedCellScanBeamforming runs the exhaustive CellScanBeamforming search
+ * once per gNB-UE link and remembers the winning beam ids. The periodic
+ * beamforming updates of IdealBeamformingHelper and later runs of the same
+ * deployment (same key, see nr-simulation's ChannelCacheKey) rebuild the
+ * vectors directly from those ids while both endpoints stay where they
+ * were; a link whose endpoints moved is searched again.
+ *
+ * File layout (little-endian): a 32-byte FileHeader, the deployment key
+ * padded to 8 bytes, then recordCount fixed-size Records.
+ */
+
+#ifndef NR_SIM_BEAM_CACHE_H
+#define NR_SIM_BEAM_CACHE_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+#include "nr-sim-result-cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+class CachedCellScanBeamforming : public CellScanBeamforming {
+public:
+  static const uint32_t kVersion = 1;
+
+  struct FileHeader {
+    char magic[4];          // "NRBF"
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t keyBytes;
+    uint64_t keyHash;
+    uint64_t reserved;
+  };
+
+  struct Record {
+    uint32_t gnbNodeId;
+    uint32_t ueNodeId;
+    double gnbPosition[3];
+    double uePosition[3];
+    double gnbElevation;
+    double ueElevation;
+    uint64_t searchNs;      // Wall time the original search took
+    uint16_t gnbSector;
+    uint16_t ueSector;
+    uint32_t reserved;
+  };
+
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::CachedCellScanBeamforming")
+                          .SetParent<CellScanBeamforming>()
+                          .SetGroupName("Nr")
+                          .AddConstructor<CachedCellScanBeamforming>();
+    return tid;
+  }
+
+  // Load the beam pairs stored for key inside dir (if any). Without a call,
+  // or with an empty dir, beam pairs are only reused within this process.
+  static void Configure(const std::string& dir, const std::string& key) {
+    Store& store = GetStore();
+    store = Store();
+    store.key = key;
+    if (dir.empty()) {
+      return;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.nrbf",
+                  static_cast<unsigned long long>(ResultCache::Hash(key)));
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+      return;
+    }
+    store.path = dir + "/" + name;
+    Load(store);
+  }
+
+  // Rewrite the beam file with every link known to this process
+  static bool Save() {
+    Store& store = GetStore();
+    if (store.path.empty() || store.searches == 0) {
+      return true;
+    }
+    std::string temp = store.path + ".tmp." + std::to_string(getpid());
+    std::ofstream out(temp, std::ios::binary);
+    FileHeader header = {};
+    std::memcpy(header.magic, "NRBF", 4);
+    header.version = kVersion;
+    header.recordCount = store.links.size();
+    header.keyBytes = store.key.size();
+    header.keyHash = ResultCache::Hash(store.key);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(store.key.data(), store.key.size());
+    static const char zeros[8] = {};
+    out.write(zeros, (8 - store.key.size() % 8) % 8);
+    for (const auto& link : store.links) {
+      out.write(reinterpret_cast<const char*>(&link.second), sizeof(Record));
+    }
+    out.close();
+    if (!out || std::rename(temp.c_str(), store.path.c_str()) != 0) {
+      std::remove(temp.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  static bool IsConfigured() { return !GetStore().key.empty(); }
+
+  static std::string StatsToJson() {
+    const Store& store = GetStore();
+    std::ostringstream out;
+    out << "{\"file\": \"" << store.path << "\", \"linksLoaded\": " << store.loaded
+        << ", \"searches\": " << store.searches << ", \"reuses\": " << store.reuses
+        << ", \"searchTime\": " << store.searchNs * 1e-9
+        << ", \"meanSearchTime\": " << (store.searches > 0 ? store.searchNs * 1e-9 / store.searches : 0.0)
+        << ", \"savedTime\": " << store.savedNs * 1e-9 << "}";
+    return out.str();
+  }
+
+  BeamformingVectorPair GetBeamformingVectors(const Ptr<NrSpectrumPhy>& gnbSpectrumPhy,
+                                              const Ptr<NrSpectrumPhy>& ueSpectrumPhy) const override {
+    Store& store = GetStore();
+    uint32_t gnbId = gnbSpectrumPhy->GetDevice()->GetNode()->GetId();
+    uint32_t ueId = ueSpectrumPhy->GetDevice()->GetNode()->GetId();
+    Vector gnbPosition = gnbSpectrumPhy->GetMobility()->GetPosition();
+    Vector uePosition = ueSpectrumPhy->GetMobility()->GetPosition();
+    uint64_t link = (uint64_t(gnbId) << 32) | ueId;
+
+    auto it = store.links.find(link);
+    if (it != store.links.end() && SamePosition(it->second.gnbPosition, gnbPosition) &&
+        SamePosition(it->second.uePosition, uePosition)) {
+      const Record& r = it->second;
+      Ptr<const UniformPlanarArray> gnbAntenna = gnbSpectrumPhy->GetAntenna()->GetObject<UniformPlanarArray>();
+      Ptr<const UniformPlanarArray> ueAntenna = ueSpectrumPhy->GetAntenna()->GetObject<UniformPlanarArray>();
+      store.reuses++;
+      store.savedNs += r.searchNs;
+      return BeamformingVectorPair(
+        BeamformingVector(CreateDirectionalBfv(gnbAntenna, r.gnbSector, r.gnbElevation),
+                          BeamId(r.gnbSector, r.gnbElevation)),
+        BeamformingVector(CreateDirectionalBfv(ueAntenna, r.ueSector, r.ueElevation),
+                          BeamId(r.ueSector, r.ueElevation)));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    BeamformingVectorPair pair = CellScanBeamforming::GetBeamformingVectors(gnbSpectrumPhy, ueSpectrumPhy);
+    double searchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    store.searches++;
+    store.searchNs += searchNs;
+
+    Record r = {};
+    r.gnbNodeId = gnbId;
+    r.ueNodeId = ueId;
+    SetPosition(r.gnbPosition, gnbPosition);
+    SetPosition(r.uePosition, uePosition);
+    r.gnbSector = pair.first.second.GetSector();
+    r.gnbElevation = pair.first.second.GetElevation();
+    r.ueSector = pair.second.second.GetSector();
+    r.ueElevation = pair.second.second.GetElevation();
+    r.searchNs = static_cast<uint64_t>(searchNs);
+    store.links[link] = r;
+    return pair;
+  }
+
+private:
+  // Process-wide state shared by the algorithm instances of every gNB
+  struct Store {
+    std::string path;
+    std::string key;
+    std::unordered_map<uint64_t, Record> links;  // gNB node id << 32 | UE node id
+    uint64_t loaded = 0;
+    uint64_t searches = 0;
+    uint64_t reuses = 0;
+    double searchNs = 0;
+    double savedNs = 0;
+  };
+
+  static Store& GetStore() {
+    static Store store;
+    return store;
+  }
+
+  static bool SamePosition(const double stored[3], const Vector& position) {
+    return std::fabs(stored[0] - position.x) < 1e-6 && std::fabs(stored[1] - position.y) < 1e-6 &&
+           std::fabs(stored[2] - position.z) < 1e-6;
+  }
+
+  static void SetPosition(double stored[3], const Vector& position) {
+    stored[0] = position.x;
+    stored[1] = position.y;
+    stored[2] = position.z;
+  }
+
+  // Read a beam file written for the same key; anything else is ignored
+  // and overwritten on Save()
+  static void Load(Store& store) {
+    int fd = open(store.path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(FileHeader))) {
+      mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      return;
+    }
+    const char* data = static_cast<const char*>(mapped);
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    size_t recordsAt = sizeof(header) + (size_t(header.keyBytes) + 7) / 8 * 8;
+    if (std::memcmp(header.magic, "NRBF", 4) == 0 && header.version == kVersion &&
+        header.keyBytes == store.key.size() && recordsAt <= size_t(st.st_size) &&
+        std::memcmp(data + sizeof(header), store.key.data(), header.keyBytes) == 0) {
+      size_t count = std::min<size_t>(header.recordCount, (st.st_size - recordsAt) / sizeof(Record));
+      for (size_t i = 0; i < count; i++) {
+        Record r;
+        std::memcpy(&r, data + recordsAt + i * sizeof(Record), sizeof(r));
+        store.links[(uint64_t(r.gnbNodeId) << 32) | r.ueNodeId] = r;
+      }
+      store.loaded = count;
+    }
+    munmap(mapped, st.st_size);
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED(CachedCellScanBeamforming);
+
+} // namespace ns3
+
+#endif /* NR_SIM_BEAM_CACHE_H */
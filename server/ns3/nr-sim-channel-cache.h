@@ -0,0 +1,627 @@
+/*
+ * Persistent 3GPP channel state for static deployments.
+ *
+ * PersistentThreeGppChannelModel is a ThreeGppChannelModel that serves
+ * channel matrices and their full ThreeGppChannelParams (cluster delays,
+ * angles and powers, ray angles, phases and cross-polarisation ratios, LOS
+ * and O2I condition) from a file generated by an earlier run with the same
+ * geometry, frequency, scenario and seed. Links missing from
+ * the file are generated as usual and appended when the run saves. One file
+ * covers one deployment key and is mapped read-only and shared, so
+ * concurrent sweep workers that only differ in power or bandwidth share
+ * the page cache instead of each regenerating the same channels.
+ *
+ * File layout (little-endian, 8-byte aligned):
+ *
+ *   FileHeader                          32 bytes
+ *   char key[keyBytes]                  canonical deployment key, padded
+ *   record*                             recordCount times
+ *
+ * A record is a RecordHeader followed by the channel coefficients
+ * (complex<double>, rows * cols * pages, column-major as in
+ * ComplexMatrixArray), the cluster delays (double[clusters]), the cluster
+ * angles (double[angleRows][clusters]) and paramsBytes of further
+ * parameters (see ParamsWriter).
+ *
+ * A reused link still draws its channel condition, as generating it did,
+ * so the condition model's random stream stays in step with the run that
+ * wrote the file; a record whose LOS state no longer matches is generated
+ * again.
+ *
+ * Only valid while nodes do not move and the channel UpdatePeriod is 0. An
+ * instance with a non-zero UpdatePeriod regenerates channels over time, so
+ * it bypasses the cache and behaves exactly like ThreeGppChannelModel.
+ *
+ * The header's peak RSS field records the memory high-water mark of the run
+ * that generated the file from nothing, so every later run can report its
+ * own peak next to the uncached one.
+ */
+
+#ifndef NR_SIM_CHANNEL_CACHE_H
+#define NR_SIM_CHANNEL_CACHE_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/spectrum-module.h"
+#include "nr-sim-result-cache.h"
+#include "nr-sim-wrap-around.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <valarray>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+// Derives from the wrap-around model so generated links are mirrored too;
+// without wrap-around that is a plain ThreeGppChannelModel
+class PersistentThreeGppChannelModel : public WrapAroundThreeGppChannelModel {
+public:
+  static const uint32_t kVersion = 2;
+
+  struct FileHeader {
+    char magic[4];          // "NRCH"
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t keyBytes;      // Length of the key without padding
+    uint64_t keyHash;
+    uint64_t uncachedPeakRssKb; // Peak RSS of the run that generated every link
+  };
+
+  struct RecordHeader {
+    uint32_t nodeIds[2];    // Link endpoints, lower node id first
+    uint32_t antennaIds[2]; // Antenna on each endpoint, same order
+    double positions[2][3]; // Endpoint positions at generation time
+    uint32_t matrixNodeIds[2];
+    uint32_t matrixAntennaPair[2];
+    uint32_t paramsNodeIds[2]; // ChannelParams::m_nodeIds, in generation order
+    int64_t generatedTimeNs;
+    uint64_t generationNs;  // Wall time the original generation took
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t pages;
+    uint32_t clusters;
+    uint32_t angleRows;
+    uint32_t paramsBytes;
+    double alpha;
+    double doppler;         // ChannelParams::m_D
+  };
+
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::PersistentThreeGppChannelModel")
+                          .SetParent<WrapAroundThreeGppChannelModel>()
+                          .SetGroupName("Spectrum")
+                          .AddConstructor<PersistentThreeGppChannelModel>();
+    return tid;
+  }
+
+  PersistentThreeGppChannelModel() { GetStore().instances++; }
+
+  // Point every instance in this process at the file for key inside dir,
+  // mapping it if it exists. Call before any channel model is created.
+  static void Configure(const std::string& dir, const std::string& key) {
+    Store& store = GetStore();
+    if (store.mapped != nullptr) {
+      munmap(store.mapped, store.mappedSize);
+    }
+    store = Store();
+    store.key = key;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.nrch",
+                  static_cast<unsigned long long>(ResultCache::Hash(key)));
+    store.path = dir + "/" + name;
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+      store.path.clear();
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    Map(store);
+    store.loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  static bool IsConfigured() { return !GetStore().path.empty(); }
+
+  // Instances created since Configure(); 0 means the spectrum model never
+  // picked up this TypeId and the cache is silently unused
+  static uint32_t GetInstanceCount() { return GetStore().instances; }
+
+  // Write the mapped records plus every link generated in this run to a
+  // temporary file and rename it over the channel file
+  static bool Save() {
+    Store& store = GetStore();
+    if (store.path.empty() || store.generated.empty()) {
+      return true;
+    }
+    std::string temp = store.path + ".tmp." + std::to_string(getpid());
+    std::ofstream out(temp, std::ios::binary);
+    FileHeader header = {};
+    std::memcpy(header.magic, "NRCH", 4);
+    header.version = kVersion;
+    header.recordCount = store.records.size() + store.generated.size();
+    header.keyBytes = store.key.size();
+    header.keyHash = ResultCache::Hash(store.key);
+    header.uncachedPeakRssKb = store.records.empty() ? PeakRssKb() : store.uncachedPeakRssKb;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(store.key.data(), store.key.size());
+    Pad(out, store.key.size());
+    for (const auto& entry : store.records) {
+      out.write(entry.second.first, entry.second.second);
+    }
+    for (const std::string& record : store.generated) {
+      out.write(record.data(), record.size());
+    }
+    out.close();
+    if (!out || std::rename(temp.c_str(), store.path.c_str()) != 0) {
+      std::remove(temp.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  static std::string StatsToJson() {
+    const Store& store = GetStore();
+    std::ostringstream out;
+    out << "{\"file\": \"" << store.path << "\", \"linksLoaded\": " << store.records.size()
+        << ", \"linksReused\": " << store.reused << ", \"linksGenerated\": " << store.generated.size()
+        << ", \"loadTime\": " << store.loadTime << ", \"reuseTime\": " << store.reuseNs * 1e-9
+        << ", \"generationTime\": " << store.generationNs * 1e-9
+        << ", \"savedTime\": " << std::max(0.0, (store.savedNs - store.reuseNs) * 1e-9)
+        << ", \"instances\": " << store.instances << ", \"bypassedInstances\": " << store.bypassed
+        << ", \"peakRssKb\": " << PeakRssKb() << ", \"uncachedPeakRssKb\": "
+        << (store.records.empty() ? PeakRssKb() : store.uncachedPeakRssKb) << "}";
+    return out.str();
+  }
+
+  Ptr<const ChannelMatrix> GetChannel(Ptr<const MobilityModel> aMob, Ptr<const MobilityModel> bMob,
+                                      Ptr<const PhasedArrayModel> aAntenna,
+                                      Ptr<const PhasedArrayModel> bAntenna) override {
+    Store& store = GetStore();
+    if (store.path.empty() || !IsStatic()) {
+      return WrapAroundThreeGppChannelModel::GetChannel(aMob, bMob, aAntenna, bAntenna);
+    }
+    LinkKey key = MakeLinkKey(aMob, bMob, aAntenna, bAntenna);
+    auto served = store.channels.find(key);
+    if (served != store.channels.end()) {
+      return served->second;
+    }
+
+    // Reuse a stored record if the endpoints are still where they were
+    auto stored = store.records.find(key);
+    if (stored != store.records.end()) {
+      auto start = std::chrono::steady_clock::now();
+      Ptr<ChannelMatrix> channel;
+      Ptr<ChannelParams> params;
+      if (Decode(stored->second.first, aMob, bMob, key, GetChannelConditionModel(), channel, params,
+                 store.savedNs)) {
+        store.channels[key] = channel;
+        store.params[NodeKey(key)] = params;
+        store.reused++;
+        store.reuseNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return channel;
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Ptr<const ChannelMatrix> channel = WrapAroundThreeGppChannelModel::GetChannel(aMob, bMob, aAntenna, bAntenna);
+    Ptr<const ChannelParams> params = ThreeGppChannelModel::GetParams(aMob, bMob);
+    double generationNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    store.generationNs += generationNs;
+    store.channels[key] = channel;
+    store.generated.push_back(Encode(key, aMob, bMob, channel, params, generationNs));
+    return channel;
+  }
+
+  Ptr<const ChannelParams> GetParams(Ptr<const MobilityModel> aMob,
+                                     Ptr<const MobilityModel> bMob) const override {
+    const Store& store = GetStore();
+    if (!m_static) {
+      return ThreeGppChannelModel::GetParams(aMob, bMob);
+    }
+    uint32_t a = aMob->GetObject<Node>()->GetId();
+    uint32_t b = bMob->GetObject<Node>()->GetId();
+    auto it = store.params.find(std::make_pair(std::min(a, b), std::max(a, b)));
+    if (it != store.params.end()) {
+      return it->second;
+    }
+    return ThreeGppChannelModel::GetParams(aMob, bMob);
+  }
+
+private:
+  // Whether this instance keeps channels forever (UpdatePeriod 0); checked
+  // on first use, once the helpers have set the attributes
+  bool IsStatic() {
+    if (m_updatePeriodChecked) {
+      return m_static;
+    }
+    TimeValue period;
+    GetAttribute("UpdatePeriod", period);
+    m_static = period.Get().IsZero();
+    m_updatePeriodChecked = true;
+    if (!m_static) {
+      GetStore().bypassed++;
+    }
+    return m_static;
+  }
+
+  static long PeakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+  // (lower node id, higher node id, antenna on lower, antenna on higher)
+  typedef std::tuple<uint32_t, uint32_t, uint32_t, uint32_t> LinkKey;
+  typedef std::pair<uint32_t, uint32_t> NodePair;
+
+  struct LinkKeyHash {
+    size_t operator()(const LinkKey& k) const {
+      uint64_t h = (uint64_t(std::get<0>(k)) << 32) ^ std::get<1>(k);
+      h = h * 0x9E3779B97F4A7C15ULL ^ ((uint64_t(std::get<2>(k)) << 32) | std::get<3>(k));
+      return std::hash<uint64_t>()(h);
+    }
+  };
+
+  struct NodePairHash {
+    size_t operator()(const NodePair& p) const {
+      return std::hash<uint64_t>()((uint64_t(p.first) << 32) | p.second);
+    }
+  };
+
+  // Process-wide state shared by every channel model instance
+  struct Store {
+    std::string path;
+    std::string key;
+    void* mapped = nullptr;
+    size_t mappedSize = 0;
+    std::unordered_map<LinkKey, std::pair<const char*, size_t>, LinkKeyHash> records;
+    std::unordered_map<LinkKey, Ptr<const ChannelMatrix>, LinkKeyHash> channels;
+    std::unordered_map<NodePair, Ptr<const ChannelParams>, NodePairHash> params;
+    std::vector<std::string> generated;
+    uint64_t reused = 0;
+    uint32_t instances = 0;
+    uint32_t bypassed = 0;  // Instances with a non-zero UpdatePeriod
+    uint64_t uncachedPeakRssKb = 0;
+    double loadTime = 0;
+    double reuseNs = 0;
+    double generationNs = 0;
+    double savedNs = 0;
+  };
+
+  static Store& GetStore() {
+    static Store store;
+    return store;
+  }
+
+  static NodePair NodeKey(const LinkKey& key) { return NodePair(std::get<0>(key), std::get<1>(key)); }
+
+  static LinkKey MakeLinkKey(Ptr<const MobilityModel> aMob, Ptr<const MobilityModel> bMob,
+                             Ptr<const PhasedArrayModel> aAntenna, Ptr<const PhasedArrayModel> bAntenna) {
+    uint32_t a = aMob->GetObject<Node>()->GetId();
+    uint32_t b = bMob->GetObject<Node>()->GetId();
+    if (a <= b) {
+      return LinkKey(a, b, aAntenna->GetId(), bAntenna->GetId());
+    }
+    return LinkKey(b, a, bAntenna->GetId(), aAntenna->GetId());
+  }
+
+  static size_t PayloadBytes(const RecordHeader& r) {
+    return (size_t(r.rows) * r.cols * r.pages * 2 + r.clusters + size_t(r.angleRows) * r.clusters) * sizeof(double) +
+           r.paramsBytes;
+  }
+
+  // The parameters beyond delays and angles, as a flat run of doubles: the
+  // angles' sin/cos pairs as the model computed them, a 1 or 0 for whether
+  // ThreeGppChannelParams follow, then each of its fields in declaration
+  // order. Vectors are prefixed by their length.
+  struct ParamsWriter {
+    std::string bytes;
+
+    void Put(double value) { bytes.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+    void Put(const Vector& v) {
+      Put(v.x);
+      Put(v.y);
+      Put(v.z);
+    }
+    void Put(const std::pair<double, double>& pair) {
+      Put(pair.first);
+      Put(pair.second);
+    }
+    template <class T>
+    void Put(const std::vector<T>& values) {
+      Put(static_cast<double>(values.size()));
+      for (const T& value : values) {
+        Put(value);
+      }
+    }
+  };
+
+  struct ParamsReader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    void Get(double& value) {
+      value = 0;
+      if (!ok || size_t(end - p) < sizeof(double)) {
+        ok = false;
+        return;
+      }
+      std::memcpy(&value, p, sizeof(value));
+      p += sizeof(value);
+    }
+    void Get(Vector& v) {
+      Get(v.x);
+      Get(v.y);
+      Get(v.z);
+    }
+    void Get(std::pair<double, double>& pair) {
+      Get(pair.first);
+      Get(pair.second);
+    }
+    template <class T>
+    void Get(std::vector<T>& values) {
+      double n;
+      Get(n);
+      values.clear();
+      if (!ok || n < 0 || n > double(end - p) / sizeof(double)) {
+        ok = false;
+        return;
+      }
+      values.resize(static_cast<size_t>(n));
+      for (T& value : values) {
+        Get(value);
+      }
+    }
+    // Enumerations and small integers
+    template <class T>
+    void GetAs(T& value) {
+      double v;
+      Get(v);
+      value = static_cast<T>(static_cast<int64_t>(v));
+    }
+  };
+
+  static std::string EncodeParams(Ptr<const ChannelParams> params) {
+    ParamsWriter out;
+    out.Put(params->m_cachedAngleSincos);
+    Ptr<const ThreeGppChannelParams> full = DynamicCast<const ThreeGppChannelParams>(params);
+    out.Put(full ? 1.0 : 0.0);
+    if (full) {
+      out.Put(static_cast<double>(full->m_losCondition));
+      out.Put(static_cast<double>(full->m_o2iCondition));
+      out.Put(full->m_nonSelfBlocking);
+      out.Put(full->m_preLocUT);
+      out.Put(full->m_locUT);
+      out.Put(full->m_norRvAngles);
+      out.Put(full->m_DS);
+      out.Put(full->m_K_factor);
+      out.Put(static_cast<double>(full->m_reducedClusterNumber));
+      out.Put(full->m_rayAodRadian);
+      out.Put(full->m_rayAoaRadian);
+      out.Put(full->m_rayZodRadian);
+      out.Put(full->m_rayZoaRadian);
+      out.Put(full->m_clusterPhase);
+      out.Put(full->m_crossPolarizationPowerRatios);
+      out.Put(full->m_speed);
+      out.Put(full->m_dis2D);
+      out.Put(full->m_dis3D);
+      out.Put(full->m_clusterPower);
+      out.Put(full->m_attenuation_dB);
+      out.Put(static_cast<double>(full->m_cluster1st));
+      out.Put(static_cast<double>(full->m_cluster2nd));
+    }
+    return out.bytes;
+  }
+
+  // Fills params, which is a ThreeGppChannelParams if the record says so
+  static bool DecodeParams(const char* p, size_t bytes, Ptr<ChannelParams>& params) {
+    ParamsReader in = {p, p + bytes};
+    std::vector<std::vector<std::pair<double, double>>> sincos;
+    double isFull;
+    in.Get(sincos);
+    in.Get(isFull);
+    if (isFull != 0) {
+      Ptr<ThreeGppChannelParams> full = Create<ThreeGppChannelParams>();
+      in.GetAs(full->m_losCondition);
+      in.GetAs(full->m_o2iCondition);
+      in.Get(full->m_nonSelfBlocking);
+      in.Get(full->m_preLocUT);
+      in.Get(full->m_locUT);
+      in.Get(full->m_norRvAngles);
+      in.Get(full->m_DS);
+      in.Get(full->m_K_factor);
+      in.GetAs(full->m_reducedClusterNumber);
+      in.Get(full->m_rayAodRadian);
+      in.Get(full->m_rayAoaRadian);
+      in.Get(full->m_rayZodRadian);
+      in.Get(full->m_rayZoaRadian);
+      in.Get(full->m_clusterPhase);
+      in.Get(full->m_crossPolarizationPowerRatios);
+      in.Get(full->m_speed);
+      in.Get(full->m_dis2D);
+      in.Get(full->m_dis3D);
+      in.Get(full->m_clusterPower);
+      in.Get(full->m_attenuation_dB);
+      in.GetAs(full->m_cluster1st);
+      in.GetAs(full->m_cluster2nd);
+      params = full;
+    } else {
+      params = Create<ChannelParams>();
+    }
+    params->m_cachedAngleSincos = std::move(sincos);
+    return in.ok && in.p == in.end;
+  }
+
+  static void Pad(std::ostream& out, size_t bytes) {
+    static const char zeros[8] = {};
+    out.write(zeros, (8 - bytes % 8) % 8);
+  }
+
+  // Map an existing channel file and index its records by link
+  static void Map(Store& store) {
+    int fd = open(store.path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+      close(fd);
+      return;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      return;
+    }
+    store.mapped = mapped;
+    store.mappedSize = st.st_size;
+    const char* data = static_cast<const char*>(mapped);
+    const char* end = data + st.st_size;
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, "NRCH", 4) != 0 || header.version != kVersion ||
+        header.keyBytes != store.key.size() || sizeof(header) + header.keyBytes > size_t(st.st_size) ||
+        std::memcmp(data + sizeof(header), store.key.data(), header.keyBytes) != 0) {
+      return;  // Stale or foreign file: regenerate and overwrite on Save()
+    }
+    store.uncachedPeakRssKb = header.uncachedPeakRssKb;
+    const char* p = data + sizeof(header) + (header.keyBytes + 7) / 8 * 8;
+    for (uint32_t i = 0; i < header.recordCount && p + sizeof(RecordHeader) <= end; i++) {
+      RecordHeader r;
+      std::memcpy(&r, p, sizeof(r));
+      size_t bytes = sizeof(r) + PayloadBytes(r);
+      if (p + bytes > end) {
+        break;
+      }
+      store.records[LinkKey(r.nodeIds[0], r.nodeIds[1], r.antennaIds[0], r.antennaIds[1])] =
+        std::make_pair(p, bytes);
+      p += bytes;
+    }
+  }
+
+  static std::string Encode(const LinkKey& key, Ptr<const MobilityModel> aMob, Ptr<const MobilityModel> bMob,
+                            Ptr<const ChannelMatrix> channel, Ptr<const ChannelParams> params,
+                            double generationNs) {
+    bool swapped = aMob->GetObject<Node>()->GetId() != std::get<0>(key);
+    Vector pa = (swapped ? bMob : aMob)->GetPosition();
+    Vector pb = (swapped ? aMob : bMob)->GetPosition();
+    RecordHeader r = {};
+    r.nodeIds[0] = std::get<0>(key);
+    r.nodeIds[1] = std::get<1>(key);
+    r.antennaIds[0] = std::get<2>(key);
+    r.antennaIds[1] = std::get<3>(key);
+    double positions[2][3] = {{pa.x, pa.y, pa.z}, {pb.x, pb.y, pb.z}};
+    std::memcpy(r.positions, positions, sizeof(positions));
+    r.matrixNodeIds[0] = channel->m_nodeIds.first;
+    r.matrixNodeIds[1] = channel->m_nodeIds.second;
+    r.matrixAntennaPair[0] = channel->m_antennaPair.first;
+    r.matrixAntennaPair[1] = channel->m_antennaPair.second;
+    r.paramsNodeIds[0] = params->m_nodeIds.first;
+    r.paramsNodeIds[1] = params->m_nodeIds.second;
+    r.generatedTimeNs = channel->m_generatedTime.GetNanoSeconds();
+    r.generationNs = static_cast<uint64_t>(generationNs);
+    r.rows = channel->m_channel.GetNumRows();
+    r.cols = channel->m_channel.GetNumCols();
+    r.pages = channel->m_channel.GetNumPages();
+    r.clusters = params->m_delay.size();
+    r.angleRows = params->m_angle.size();
+    r.alpha = params->m_alpha;
+    r.doppler = params->m_D;
+    std::string extra = EncodeParams(params);
+    r.paramsBytes = extra.size();
+
+    std::string record(sizeof(r) + PayloadBytes(r), '\0');
+    char* p = &record[0];
+    std::memcpy(p, &r, sizeof(r));
+    p += sizeof(r);
+    const std::valarray<std::complex<double>>& values = channel->m_channel.GetValues();
+    std::memcpy(p, &values[0], values.size() * sizeof(std::complex<double>));
+    p += values.size() * sizeof(std::complex<double>);
+    std::memcpy(p, params->m_delay.data(), r.clusters * sizeof(double));
+    p += r.clusters * sizeof(double);
+    for (const auto& row : params->m_angle) {
+      std::memcpy(p, row.data(), std::min<size_t>(row.size(), r.clusters) * sizeof(double));
+      p += r.clusters * sizeof(double);
+    }
+    std::memcpy(p, extra.data(), extra.size());
+    return record;
+  }
+
+  static bool Decode(const char* p, Ptr<const MobilityModel> aMob, Ptr<const MobilityModel> bMob,
+                     const LinkKey& key, Ptr<ChannelConditionModel> conditionModel, Ptr<ChannelMatrix>& channel,
+                     Ptr<ChannelParams>& params, double& savedNs) {
+    RecordHeader r;
+    std::memcpy(&r, p, sizeof(r));
+    bool swapped = aMob->GetObject<Node>()->GetId() != std::get<0>(key);
+    Vector pa = (swapped ? bMob : aMob)->GetPosition();
+    Vector pb = (swapped ? aMob : bMob)->GetPosition();
+    if (CalculateDistance(pa, Vector(r.positions[0][0], r.positions[0][1], r.positions[0][2])) > 1e-6 ||
+        CalculateDistance(pb, Vector(r.positions[1][0], r.positions[1][1], r.positions[1][2])) > 1e-6) {
+      return false;
+    }
+    p += sizeof(r);
+    const char* extra = p + PayloadBytes(r) - r.paramsBytes;
+    if (!DecodeParams(extra, r.paramsBytes, params)) {
+      return false;
+    }
+    // Draw the link's condition where generating it did (see above)
+    Ptr<const ThreeGppChannelParams> full = DynamicCast<const ThreeGppChannelParams>(params);
+    if (conditionModel) {
+      WrapAroundImage image(aMob, bMob);
+      Ptr<ChannelCondition> condition = conditionModel->GetChannelCondition(aMob, bMob);
+      if (full && condition->GetLosCondition() != full->m_losCondition) {
+        return false;
+      }
+    }
+    size_t n = size_t(r.rows) * r.cols * r.pages;
+    std::valarray<std::complex<double>> values(n);
+    std::memcpy(&values[0], p, n * sizeof(std::complex<double>));
+    p += n * sizeof(std::complex<double>);
+
+    channel = Create<ChannelMatrix>();
+    channel->m_channel = ComplexMatrixArray(r.rows, r.cols, r.pages, values);
+    channel->m_generatedTime = NanoSeconds(r.generatedTimeNs);
+    channel->m_nodeIds = std::make_pair(r.matrixNodeIds[0], r.matrixNodeIds[1]);
+    channel->m_antennaPair = std::make_pair(r.matrixAntennaPair[0], r.matrixAntennaPair[1]);
+
+    params->m_generatedTime = channel->m_generatedTime;
+    params->m_nodeIds = std::make_pair(r.paramsNodeIds[0], r.paramsNodeIds[1]);
+    params->m_alpha = r.alpha;
+    params->m_D = r.doppler;
+    params->m_delay.assign(reinterpret_cast<const double*>(p), reinterpret_cast<const double*>(p) + r.clusters);
+    p += r.clusters * sizeof(double);
+    params->m_angle.resize(r.angleRows);
+    for (uint32_t row = 0; row < r.angleRows; row++) {
+      const double* angles = reinterpret_cast<const double*>(p);
+      params->m_angle[row].assign(angles, angles + r.clusters);
+      p += r.clusters * sizeof(double);
+    }
+    savedNs += r.generationNs;
+    return true;
+  }
+
+  bool m_updatePeriodChecked = false;
+  bool m_static = true;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(PersistentThreeGppChannelModel);
+
+} // namespace ns3
+
+#endif /* NR_SIM_CHANNEL_CACHE_H */
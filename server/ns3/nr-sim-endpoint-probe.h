@@ -0,0 +1,113 @@
+/*
+ * Endpoint-only flow measurement for nr-simulation.
+ *
+ * FlowMonitorHelper::InstallAll puts an IPv4 probe on every node (UEs,
+ * gNBs, PGW/SGW, remote host), tags every packet and keeps per-flow delay,
+ * jitter and size histograms. EndpointProbe only hooks the "Tx" trace of
+ * each downlink source and the "Rx" trace of its UE's server and feeds
+ * FlowStatsCollector directly, one flow per UE, so the throughput and
+ * latency probes read the same counters either way.
+ *
+ * Byte and packet counts are exact. With a sampling period N > 1 only every
+ * N-th received packet of a flow (systematic sampling, phase = flow index
+ * mod N) has its SeqTsHeader read; its delay is counted N times in the delay
+ * sum, which is unbiased over the phase, and passed once to the delay
+ * callback, if set (the latency histogram in nr-simulation). Lost packets are those sent but not received
+ * when Finish() runs after the simulation, so they include packets still
+ * in flight at the stop time.
+ */
+
+#ifndef NR_SIM_ENDPOINT_PROBE_H
+#define NR_SIM_ENDPOINT_PROBE_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "nr-sim-flow-collector.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ns3 {
+
+class EndpointProbe {
+public:
+  EndpointProbe(FlowStatsCollector& stats, uint32_t samplingPeriod)
+    : m_stats(stats),
+      m_samplingPeriod(std::max<uint32_t>(samplingPeriod, 1)) {}
+
+  // Measure the flow from source to sink; flows are indexed in install
+  // order. Both trace sources carry a Ptr<const Packet>.
+  void Install(Ptr<Application> source, Ptr<Application> sink) {
+    uint32_t index = m_flows.size();
+    m_flows.emplace_back(new Flow(this, index));
+    Flow* flow = m_flows.back().get();
+    m_stats.AddFlow(index);
+    source->TraceConnectWithoutContext("Tx", MakeCallback(&Flow::Tx, flow));
+    sink->TraceConnectWithoutContext("Rx", MakeCallback(&Flow::Rx, flow));
+  }
+
+  // Count everything sent but not received as lost
+  void Finish() {
+    for (const auto& flow : m_flows) {
+      m_stats.SetLost(flow->index, flow->txPackets - std::min(flow->txPackets, flow->rxPackets));
+    }
+  }
+
+  // Called with the delay in ns of every sampled packet
+  void SetDelayCallback(Callback<void, int64_t> callback) { m_delayCallback = callback; }
+
+  uint32_t GetSamplingPeriod() const { return m_samplingPeriod; }
+  uint64_t GetSampledPackets() const { return m_sampled; }
+
+private:
+  // Per-flow trace sink; owned by the probe so its address stays stable
+  struct Flow {
+    Flow(EndpointProbe* probe, uint32_t index)
+      : probe(probe),
+        index(index),
+        phase(index % probe->m_samplingPeriod) {}
+
+    void Tx(Ptr<const Packet> packet) {
+      txPackets++;
+      probe->m_stats.AddTx(index, Simulator::Now().GetNanoSeconds());
+    }
+
+    void Rx(Ptr<const Packet> packet) {
+      uint64_t n = rxPackets++;
+      uint32_t period = probe->m_samplingPeriod;
+      int64_t now = Simulator::Now().GetNanoSeconds();
+      if (period > 1 && n % period != phase) {
+        probe->m_stats.AddRx(index, packet->GetSize(), 1, 0, now);
+        return;
+      }
+      SeqTsHeader seqTs;
+      int64_t delayNs = 0;
+      if (packet->PeekHeader(seqTs) == seqTs.GetSerializedSize()) {
+        delayNs = now - seqTs.GetTs().GetNanoSeconds();
+        if (!probe->m_delayCallback.IsNull()) {
+          probe->m_delayCallback(delayNs);
+        }
+      }
+      probe->m_sampled++;
+      probe->m_stats.AddRx(index, packet->GetSize(), 1, delayNs * period, now);
+    }
+
+    EndpointProbe* probe;
+    uint32_t index;
+    uint32_t phase;
+    uint64_t txPackets = 0;
+    uint64_t rxPackets = 0;
+  };
+
+  FlowStatsCollector& m_stats;
+  uint32_t m_samplingPeriod;
+  uint64_t m_sampled = 0;
+  Callback<void, int64_t> m_delayCallback;
+  std::vector<std::unique_ptr<Flow>> m_flows;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_ENDPOINT_PROBE_H */
@@ -0,0 +1,198 @@
+/*
+ * Event-loop profiler for nr-simulation.
+ * ProfilingSimulatorImpl is a DefaultSimulatorImpl that wraps every event
+ * it schedules, so each execution is counted and timed against the dynamic
+ * type of the scheduled EventImpl (MakeEvent generates one type per
+ * callback signature and bound object type, e.g. a PHY slot handler or the
+ * UdpClient send timer). It also samples the event-queue depth. Select it
+ * with --SimulatorImplementationType=ns3::ProfilingSimulatorImpl (or
+ * --eventProfile) before the simulator is first used.
+ */
+
+#ifndef NR_SIM_EVENT_PROFILER_H
+#define NR_SIM_EVENT_PROFILER_H
+
+#include "ns3/core-module.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <sstream>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+class ProfilingSimulatorImpl : public DefaultSimulatorImpl {
+public:
+  static const uint64_t kDepthSampleEvents = 10000; // Executed events between depth samples
+
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::ProfilingSimulatorImpl")
+                          .SetParent<DefaultSimulatorImpl>()
+                          .SetGroupName("Core")
+                          .AddConstructor<ProfilingSimulatorImpl>();
+    return tid;
+  }
+
+  EventId Schedule(const Time& delay, EventImpl* event) override {
+    m_scheduled++;
+    return DefaultSimulatorImpl::Schedule(delay, Wrap(event));
+  }
+
+  void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override {
+    m_scheduled++;
+    DefaultSimulatorImpl::ScheduleWithContext(context, delay, Wrap(event));
+  }
+
+  EventId ScheduleNow(EventImpl* event) override {
+    m_scheduled++;
+    return DefaultSimulatorImpl::ScheduleNow(Wrap(event));
+  }
+
+  // Destroy-time events run after the report is taken and are not wrapped
+  void Remove(const EventId& id) override {
+    if (id.GetUid() != EventId::UID::DESTROY && !IsExpired(id)) {
+      m_removed++;
+    }
+    DefaultSimulatorImpl::Remove(id);
+  }
+
+  // Events still waiting in the queue; cancelled ones count until popped
+  uint64_t GetQueueDepth() const { return m_scheduled - m_removed - GetEventCount(); }
+
+  // Per-type totals sorted by wall time, the top `top` as JSON
+  std::string ToJson(uint32_t top) const {
+    std::vector<uint32_t> order = SortedTypes();
+    uint64_t events = 0;
+    double wallTime = 0;
+    for (const Source& s : m_sources) {
+      events += s.count;
+      wallTime += s.wallNs * 1e-9;
+    }
+    std::ostringstream out;
+    out << "{\"events\": " << events << ", \"wallTime\": " << wallTime << ", \"types\": " << m_sources.size()
+        << ", \"queueDepth\": {\"max\": " << m_maxDepth << ", \"mean\": "
+        << (events > 0 ? m_depthSum / events : 0.0) << ", \"samples\": [";
+    for (size_t i = 0; i < m_depthSamples.size(); i++) {
+      out << (i > 0 ? ", " : "") << "[" << m_depthSamples[i].first << ", " << m_depthSamples[i].second << "]";
+    }
+    out << "]}, \"top\": [";
+    for (size_t i = 0; i < order.size() && i < top; i++) {
+      const Source& s = m_sources[order[i]];
+      out << (i > 0 ? ", " : "") << "{\"type\": \"" << s.name << "\", \"count\": " << s.count
+          << ", \"wallTime\": " << s.wallNs * 1e-9 << ", \"meanNs\": " << s.wallNs / s.count
+          << ", \"share\": " << (wallTime > 0 ? s.wallNs * 1e-9 / wallTime : 0.0) << "}";
+    }
+    out << "]}";
+    return out.str();
+  }
+
+  // Fixed-width table of the same top entries, one line per entry
+  std::vector<std::string> ToTable(uint32_t top) const {
+    std::vector<uint32_t> order = SortedTypes();
+    double wallNs = 0;
+    for (const Source& s : m_sources) {
+      wallNs += s.wallNs;
+    }
+    std::vector<std::string> lines;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%12s %10s %9s %6s  %s", "events", "wall (s)", "mean ns", "share", "event type");
+    lines.push_back(line);
+    for (size_t i = 0; i < order.size() && i < top; i++) {
+      const Source& s = m_sources[order[i]];
+      std::snprintf(line, sizeof(line), "%12llu %10.4f %9.0f %5.1f%%  %.160s",
+                    static_cast<unsigned long long>(s.count), s.wallNs * 1e-9, s.wallNs / s.count,
+                    wallNs > 0 ? 100.0 * s.wallNs / wallNs : 0.0, s.name.c_str());
+      lines.push_back(line);
+    }
+    return lines;
+  }
+
+private:
+  struct Source {
+    std::string name;
+    uint64_t count = 0;
+    double wallNs = 0;
+  };
+
+  // Runs the wrapped event and charges its wall time to its source
+  class ProfiledEvent : public EventImpl {
+  public:
+    ProfiledEvent(ProfilingSimulatorImpl* owner, EventImpl* inner, uint32_t source)
+      : m_owner(owner), m_inner(inner, false), m_source(source) {}
+
+  protected:
+    void Notify() override {
+      auto start = std::chrono::steady_clock::now();
+      m_inner->Invoke();
+      auto end = std::chrono::steady_clock::now();
+      m_owner->Record(m_source, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+  private:
+    ProfilingSimulatorImpl* m_owner;
+    Ptr<EventImpl> m_inner;  // Adopts the reference the caller handed us
+    uint32_t m_source;
+  };
+
+  EventImpl* Wrap(EventImpl* event) {
+    std::type_index type(typeid(*event));
+    auto it = m_sourceIndex.find(type);
+    if (it == m_sourceIndex.end()) {
+      it = m_sourceIndex.emplace(type, m_sources.size()).first;
+      m_sources.push_back(Source{Demangle(type.name())});
+    }
+    return new ProfiledEvent(this, event, it->second);
+  }
+
+  void Record(uint32_t source, double wallNs) {
+    m_sources[source].count++;
+    m_sources[source].wallNs += wallNs;
+    uint64_t depth = GetQueueDepth();
+    m_maxDepth = std::max(m_maxDepth, depth);
+    m_depthSum += depth;
+    if (++m_executed % kDepthSampleEvents == 0) {
+      m_depthSamples.emplace_back(Now().GetSeconds(), depth);
+    }
+  }
+
+  std::vector<uint32_t> SortedTypes() const {
+    std::vector<uint32_t> order(m_sources.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+              [this](uint32_t a, uint32_t b) { return m_sources[a].wallNs > m_sources[b].wallNs; });
+    return order;
+  }
+
+  // Readable type name; double quotes are dropped so it can go into JSON
+  static std::string Demangle(const char* mangled) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    std::string name = status == 0 ? demangled : mangled;
+    std::free(demangled);
+    name.erase(std::remove(name.begin(), name.end(), '"'), name.end());
+    return name;
+  }
+
+  std::unordered_map<std::type_index, uint32_t> m_sourceIndex;
+  std::vector<Source> m_sources;
+  uint64_t m_scheduled = 0;
+  uint64_t m_removed = 0;
+  uint64_t m_executed = 0;
+  uint64_t m_maxDepth = 0;
+  double m_depthSum = 0;
+  std::vector<std::pair<double, uint64_t>> m_depthSamples;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingSimulatorImpl);
+
+} // namespace ns3
+
+#endif /* NR_SIM_EVENT_PROFILER_H */
@@ -0,0 +1,156 @@
+/*
+ * Flat, index-addressed per-flow counters for nr-simulation.
+ * FlowIds handed out by FlowMonitor are dense and start at 1, so flow i
+ * lives at index i - 1 of each column. Sync() walks FlowMonitor's map in
+ * place and folds per-flow deltas into running totals, so reading totals or
+ * window deltas is O(1) and steady-state sampling never allocates.
+ * EndpointProbe feeds the same columns directly through the Add*() calls
+ * instead, with flow i being the i-th probed UE. Sync() takes any map from
+ * FlowId to FlowMonitor::FlowStats-like records, so the collector builds
+ * without ns-3 in nr-simulation-test.
+ */
+
+#ifndef NR_SIM_FLOW_COLLECTOR_H
+#define NR_SIM_FLOW_COLLECTOR_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+// Counters summed over all flows
+struct FlowTotals {
+  uint64_t txPackets = 0;
+  uint64_t rxBytes = 0;
+  uint64_t rxPackets = 0;
+  int64_t delaySumNs = 0;
+  uint64_t lostPackets = 0;
+
+  FlowTotals operator-(const FlowTotals& base) const {
+    FlowTotals d;
+    d.txPackets = txPackets - base.txPackets;
+    d.rxBytes = rxBytes - base.rxBytes;
+    d.rxPackets = rxPackets - base.rxPackets;
+    d.delaySumNs = delaySumNs - base.delaySumNs;
+    d.lostPackets = lostPackets - base.lostPackets;
+    return d;
+  }
+
+  // Packet-weighted mean one-way delay in seconds
+  double GetMeanDelay() const {
+    return rxPackets > 0 ? delaySumNs * 1e-9 / rxPackets : 0.0;
+  }
+};
+
+class FlowStatsCollector {
+public:
+  // Pre-size the columns so that syncing never reallocates
+  void Reserve(uint32_t flows) {
+    m_txPackets.reserve(flows);
+    m_rxBytes.reserve(flows);
+    m_rxPackets.reserve(flows);
+    m_delaySumNs.reserve(flows);
+    m_lostPackets.reserve(flows);
+    m_firstTxNs.reserve(flows);
+    m_lastRxNs.reserve(flows);
+  }
+
+  // Pull the monitor's cumulative counters into the columns and totals
+  // (FlowMonitor::FlowStatsContainer in nr-simulation)
+  template <class FlowStatsContainer>
+  void Sync(const FlowStatsContainer& stats) {
+    for (const auto& entry : stats) {
+      const auto& s = entry.second;
+      uint32_t i = entry.first - 1;
+      if (i >= m_rxBytes.size()) {
+        Grow(i + 1);
+      }
+      int64_t delayNs = s.delaySum.GetNanoSeconds();
+      m_totals.txPackets += s.txPackets - m_txPackets[i];
+      m_totals.rxBytes += s.rxBytes - m_rxBytes[i];
+      m_totals.rxPackets += s.rxPackets - m_rxPackets[i];
+      m_totals.delaySumNs += delayNs - m_delaySumNs[i];
+      m_totals.lostPackets += s.lostPackets - m_lostPackets[i];
+      m_txPackets[i] = s.txPackets;
+      m_rxBytes[i] = s.rxBytes;
+      m_rxPackets[i] = s.rxPackets;
+      m_delaySumNs[i] = delayNs;
+      m_lostPackets[i] = s.lostPackets;
+      m_firstTxNs[i] = s.timeFirstTxPacket.GetNanoSeconds();
+      m_lastRxNs[i] = s.timeLastRxPacket.GetNanoSeconds();
+    }
+  }
+
+  // Direct feeds used by EndpointProbe in place of Sync()
+  void AddFlow(uint32_t i) {
+    if (i >= m_rxBytes.size()) {
+      Grow(i + 1);
+    }
+  }
+
+  void AddTx(uint32_t i, int64_t nowNs) {
+    if (m_txPackets[i]++ == 0) {
+      m_firstTxNs[i] = nowNs;
+    }
+    m_totals.txPackets++;
+  }
+
+  void AddRx(uint32_t i, uint64_t bytes, uint64_t packets, int64_t delayNs, int64_t nowNs) {
+    m_rxBytes[i] += bytes;
+    m_rxPackets[i] += packets;
+    m_delaySumNs[i] += delayNs;
+    m_lastRxNs[i] = nowNs;
+    m_totals.rxBytes += bytes;
+    m_totals.rxPackets += packets;
+    m_totals.delaySumNs += delayNs;
+  }
+
+  void SetLost(uint32_t i, uint64_t lost) {
+    m_totals.lostPackets += lost - m_lostPackets[i];
+    m_lostPackets[i] = lost;
+  }
+
+  const FlowTotals& GetTotals() const { return m_totals; }
+  uint32_t GetNFlows() const { return m_rxBytes.size(); }
+
+  uint64_t GetRxBytes(uint32_t i) const { return m_rxBytes[i]; }
+  uint64_t GetRxPackets(uint32_t i) const { return m_rxPackets[i]; }
+  int64_t GetDelaySumNs(uint32_t i) const { return m_delaySumNs[i]; }
+  uint64_t GetLostPackets(uint32_t i) const { return m_lostPackets[i]; }
+
+  // Sum of each flow's rx rate over its own active period, in bps
+  double GetActiveThroughput() const {
+    double total = 0.0;
+    for (uint32_t i = 0; i < m_rxBytes.size(); i++) {
+      int64_t activeNs = m_lastRxNs[i] - m_firstTxNs[i];
+      if (m_rxBytes[i] > 0 && activeNs > 0) {
+        total += m_rxBytes[i] * 8.0 / (activeNs * 1e-9);
+      }
+    }
+    return total;
+  }
+
+private:
+  void Grow(uint32_t flows) {
+    m_txPackets.resize(flows, 0);
+    m_rxBytes.resize(flows, 0);
+    m_rxPackets.resize(flows, 0);
+    m_delaySumNs.resize(flows, 0);
+    m_lostPackets.resize(flows, 0);
+    m_firstTxNs.resize(flows, 0);
+    m_lastRxNs.resize(flows, 0);
+  }
+
+  FlowTotals m_totals;
+  std::vector<uint64_t> m_txPackets;
+  std::vector<uint64_t> m_rxBytes;
+  std::vector<uint64_t> m_rxPackets;
+  std::vector<int64_t> m_delaySumNs;
+  std::vector<uint64_t> m_lostPackets;
+  std::vector<int64_t> m_firstTxNs;
+  std::vector<int64_t> m_lastRxNs;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_FLOW_COLLECTOR_H */
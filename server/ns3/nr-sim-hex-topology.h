@@ -0,0 +1,150 @@
+/*
+ * 3GPP-style hexagonal multi-site layout for nr-simulation.
+ * Sites sit on a hexagonal lattice with inter-site distance isd, filled ring
+ * by ring around the origin (1, 7, 19, 37, ... sites). Every site carries
+ * sectorsPerSite co-located cells whose boresights are evenly spaced
+ * starting at 30 degrees, and UEs are dropped uniformly inside their cell's
+ * part of the site hexagon. A complete set of rings tiles the plane with
+ * six shifted copies of itself, which nr-sim-wrap-around.h uses to give
+ * every cell a full ring of interferers.
+ */
+
+#ifndef NR_SIM_HEX_TOPOLOGY_H
+#define NR_SIM_HEX_TOPOLOGY_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+class HexTopology {
+public:
+  HexTopology(uint32_t sites, uint32_t sectorsPerSite, double isd)
+    : m_sectors(sectorsPerSite), m_isd(isd) {
+    // Axial lattice coordinates, ring by ring
+    m_axial.push_back({0, 0});
+    static const int directions[6][2] = {{1, 0}, {0, 1}, {-1, 1}, {-1, 0}, {0, -1}, {1, -1}};
+    for (int ring = 1; m_axial.size() < sites; ring++) {
+      int q = directions[4][0] * ring;
+      int r = directions[4][1] * ring;
+      for (int side = 0; side < 6; side++) {
+        for (int step = 0; step < ring; step++) {
+          m_axial.push_back({q, r});
+          q += directions[side][0];
+          r += directions[side][1];
+        }
+      }
+      m_rings = ring;
+    }
+    m_axial.resize(sites);
+  }
+
+  uint32_t GetNSites() const { return m_axial.size(); }
+  uint32_t GetNCells() const { return m_axial.size() * m_sectors; }
+
+  // Cells are numbered sector-major so one antenna bearing covers a range
+  uint32_t GetSite(uint32_t cell) const { return cell % m_axial.size(); }
+  uint32_t GetSector(uint32_t cell) const { return cell / m_axial.size(); }
+
+  Vector GetSitePosition(uint32_t site, double height) const {
+    double q = m_axial[site][0];
+    double r = m_axial[site][1];
+    return Vector(m_isd * (q + r / 2.0), m_isd * r * std::sqrt(3.0) / 2.0, height);
+  }
+
+  // Boresight of a sector in radians, counter-clockwise from the x axis
+  double GetBearing(uint32_t sector) const {
+    return (30.0 + 360.0 * sector / m_sectors) * M_PI / 180.0;
+  }
+
+  // True when the layout is a complete set of rings, which wrap-around needs
+  bool IsFullRings() const {
+    return m_axial.size() == static_cast<size_t>(3 * m_rings * (m_rings + 1) + 1);
+  }
+
+  // Offsets of the six copies of a full-ring cluster that tile the plane
+  // around it: (2n + 1, -n) in axial coordinates for n rings, rotated in
+  // 60 degree steps. Empty for an incomplete layout.
+  std::vector<Vector> GetWrapAroundShifts() const {
+    std::vector<Vector> shifts;
+    if (!IsFullRings()) {
+      return shifts;
+    }
+    int q = 2 * m_rings + 1;
+    int r = -m_rings;
+    for (int k = 0; k < 6; k++) {
+      shifts.push_back(Vector(m_isd * (q + r / 2.0), m_isd * r * std::sqrt(3.0) / 2.0, 0));
+      int rotated = -r;  // (q, r) -> (-r, q + r)
+      r = q + r;
+      q = rotated;
+    }
+    return shifts;
+  }
+
+  // Cell serving a point: nearest site, then the sector whose angular
+  // span contains the point as seen from that site. UEs are dropped inside
+  // their site's hexagon, which is also its region under wrap-around, so
+  // the plain distance picks the same site.
+  uint32_t GetServingCell(const Vector& point) const {
+    uint32_t bestSite = 0;
+    double bestDistance = INFINITY;
+    double bestAngle = 0;
+    for (uint32_t site = 0; site < m_axial.size(); site++) {
+      Vector s = GetSitePosition(site, 0);
+      double dx = point.x - s.x;
+      double dy = point.y - s.y;
+      double distance = std::hypot(dx, dy);
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        bestSite = site;
+        bestAngle = std::atan2(dy, dx);
+      }
+    }
+    double offset = std::fmod(bestAngle - GetBearing(0) + M_PI / m_sectors + 4 * M_PI, 2 * M_PI);
+    uint32_t sector = static_cast<uint32_t>(offset / (2 * M_PI / m_sectors)) % m_sectors;
+    return sector * m_axial.size() + bestSite;
+  }
+
+  // Uniform drop inside the cell's share of its site hexagon, keeping the
+  // 3GPP minimum 2D distance from the site
+  Vector DropUe(uint32_t cell, double minDistance, double height, Ptr<UniformRandomVariable> rng) const {
+    Vector site = GetSitePosition(GetSite(cell), height);
+    double circumradius = m_isd / std::sqrt(3.0);
+    double halfWidth = M_PI / m_sectors;
+    double bearing = GetBearing(GetSector(cell));
+    while (true) {
+      double radius = circumradius * std::sqrt(rng->GetValue(0.0, 1.0));
+      double angle = bearing + rng->GetValue(-halfWidth, halfWidth);
+      double x = radius * std::cos(angle);
+      double y = radius * std::sin(angle);
+      if (radius >= minDistance && InsideHexagon(x, y)) {
+        return Vector(site.x + x, site.y + y, height);
+      }
+    }
+  }
+
+private:
+  // Voronoi cell of a lattice site: apothem isd / 2 towards each neighbour
+  bool InsideHexagon(double x, double y) const {
+    for (int k = 0; k < 3; k++) {
+      double a = k * M_PI / 3.0;
+      if (std::fabs(x * std::cos(a) + y * std::sin(a)) > m_isd / 2.0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<std::array<int, 2>> m_axial;
+  uint32_t m_sectors;
+  double m_isd;
+  int m_rings = 0;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_HEX_TOPOLOGY_H */
@@ -0,0 +1,174 @@
+/*
+ * Fixed-memory, log-bucketed latency histogram for nr-simulation.
+ * Buckets grow geometrically by gamma = (1 + alpha) / (1 - alpha), so every
+ * quantile is reported within a relative error of alpha (as in DDSketch).
+ * Two histograms with the same layout merge exactly by adding counts, which
+ * is how replications and sweep shards are combined.
+ */
+
+#ifndef NR_SIM_HISTOGRAM_H
+#define NR_SIM_HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class LatencyHistogram {
+public:
+  static constexpr double kAlpha = 0.01;    // Relative accuracy of quantiles
+  static constexpr double kMinValue = 1e-6; // 1 us, smaller delays share bucket 0
+  static constexpr double kMaxValue = 100;  // 100 s, larger delays share the last bucket
+
+  LatencyHistogram() : m_counts(GetBucketCount(), 0) {}
+
+  static double GetGamma() { return (1 + kAlpha) / (1 - kAlpha); }
+
+  static uint32_t GetBucketCount() {
+    static const uint32_t buckets = 2 + static_cast<uint32_t>(std::ceil(std::log(kMaxValue / kMinValue) / std::log(GetGamma())));
+    return buckets;
+  }
+
+  void Record(double seconds) {
+    static const double logGamma = std::log(GetGamma());
+    uint32_t index = 0;
+    if (seconds > kMinValue) {
+      index = 1 + static_cast<uint32_t>(std::log(seconds / kMinValue) / logGamma);
+      index = std::min(index, GetBucketCount() - 1);
+    }
+    m_counts[index]++;
+    if (m_count == 0 || seconds < m_min) {
+      m_min = seconds;
+    }
+    if (m_count == 0 || seconds > m_max) {
+      m_max = seconds;
+    }
+    m_count++;
+    m_sum += seconds;
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    if (other.m_count == 0) {
+      return;
+    }
+    for (uint32_t i = 0; i < m_counts.size(); i++) {
+      m_counts[i] += other.m_counts[i];
+    }
+    m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+    m_max = m_count == 0 ? other.m_max : std::max(m_max, other.m_max);
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+  }
+
+  uint64_t GetCount() const { return m_count; }
+  double GetMean() const { return m_count > 0 ? m_sum / m_count : 0.0; }
+
+  // Value at quantile q in [0, 1], within kAlpha relative error
+  double GetQuantile(double q) const {
+    if (m_count == 0) {
+      return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * (m_count - 1));
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < m_counts.size(); i++) {
+      seen += m_counts[i];
+      if (seen > rank) {
+        double value = i == 0 ? kMinValue : kMinValue * std::pow(GetGamma(), i - 1) * (1 + kAlpha);
+        return std::min(std::max(value, m_min), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  std::string PercentilesToJson() const {
+    std::ostringstream out;
+    out << "{\"p50\": " << GetQuantile(0.5) << ", \"p90\": " << GetQuantile(0.9)
+        << ", \"p99\": " << GetQuantile(0.99) << ", \"p999\": " << GetQuantile(0.999) << "}";
+    return out.str();
+  }
+
+  // Sparse serialization: only non-empty buckets as [index, count] pairs
+  std::string ToJson() const {
+    std::ostringstream out;
+    out.precision(17);
+    out << "{\"alpha\": " << kAlpha << ", \"minValue\": " << kMinValue
+        << ", \"count\": " << m_count << ", \"sum\": " << m_sum
+        << ", \"min\": " << m_min << ", \"max\": " << m_max << ", \"buckets\": [";
+    bool first = true;
+    for (uint32_t i = 0; i < m_counts.size(); i++) {
+      if (m_counts[i] > 0) {
+        out << (first ? "" : ", ") << "[" << i << ", " << m_counts[i] << "]";
+        first = false;
+      }
+    }
+    out << "]}";
+    return out.str();
+  }
+
+  // Inverse of ToJson(); returns false if the layout differs from ours
+  bool FromJson(const std::string& json) {
+    auto number = [&json](const char* key, double& value) {
+      std::string::size_type p = json.find(std::string("\"") + key + "\":");
+      if (p == std::string::npos) {
+        return false;
+      }
+      value = std::strtod(json.c_str() + p + std::char_traits<char>::length(key) + 3, nullptr);
+      return true;
+    };
+    double alpha = 0;
+    double minValue = 0;
+    double count = 0;
+    if (!number("alpha", alpha) || !number("minValue", minValue) || !number("count", count) ||
+        std::fabs(alpha - kAlpha) > 1e-12 || std::fabs(minValue - kMinValue) > 1e-18) {
+      return false;
+    }
+    *this = LatencyHistogram();
+    number("sum", m_sum);
+    number("min", m_min);
+    number("max", m_max);
+    m_count = static_cast<uint64_t>(count);
+
+    std::string::size_type p = json.find("\"buckets\":");
+    if (p == std::string::npos) {
+      return false;
+    }
+    const char* c = json.c_str() + json.find('[', p) + 1;
+    while (*c != '\0' && *c != ']') {
+      if (*c != '[') {
+        c++;
+        continue;
+      }
+      char* end = nullptr;
+      unsigned long index = std::strtoul(c + 1, &end, 10);
+      unsigned long long n = std::strtoull(end + 1, &end, 10);
+      if (index >= m_counts.size()) {
+        return false;
+      }
+      m_counts[index] += n;
+      c = end;
+      while (*c != '\0' && *c != ']') {
+        c++;
+      }
+      if (*c == ']') {
+        c++;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::vector<uint64_t> m_counts;
+  uint64_t m_count = 0;
+  double m_sum = 0.0;
+  double m_min = 0.0;
+  double m_max = 0.0;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_HISTOGRAM_H */
@@ -0,0 +1,158 @@
+/*
+ * Minimal JSON field extraction for nr-simulation job and result lines.
+ * Only flat objects with string and number values are supported, which is
+ * all the portal ever sends to or reads back from the simulation. Strings
+ * taken from a job and echoed back go out through JsonQuote.
+ */
+
+#ifndef NR_SIM_JSON_H
+#define NR_SIM_JSON_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace ns3 {
+
+// Locate the first character of the value stored under key, or npos
+inline std::string::size_type JsonFindValue(const std::string& json, const std::string& key) {
+  std::string needle = "\"" + key + "\"";
+  std::string::size_type pos = json.find(needle);
+  while (pos != std::string::npos) {
+    std::string::size_type p = pos + needle.size();
+    while (p < json.size() && (json[p] == ' ' || json[p] == '\t')) {
+      p++;
+    }
+    if (p < json.size() && json[p] == ':') {
+      p++;
+      while (p < json.size() && (json[p] == ' ' || json[p] == '\t')) {
+        p++;
+      }
+      return p < json.size() ? p : std::string::npos;
+    }
+    pos = json.find(needle, pos + 1);
+  }
+  return std::string::npos;
+}
+
+// Read a numeric value; returns false if the key is missing or not a number
+inline bool JsonGetNumber(const std::string& json, const std::string& key, double& value) {
+  std::string::size_type p = JsonFindValue(json, key);
+  if (p == std::string::npos) {
+    return false;
+  }
+  const char* begin = json.c_str() + p;
+  char* end = nullptr;
+  double parsed = std::strtod(begin, &end);
+  if (end == begin) {
+    return false;
+  }
+  value = parsed;
+  return true;
+}
+
+// Quote text as a JSON string literal, escaping quotes, backslashes and
+// control characters
+inline std::string JsonQuote(const std::string& text) {
+  std::string quoted = "\"";
+  for (unsigned char c : text) {
+    switch (c) {
+      case '"': quoted += "\\\""; break;
+      case '\\': quoted += "\\\\"; break;
+      case '\n': quoted += "\\n"; break;
+      case '\r': quoted += "\\r"; break;
+      case '\t': quoted += "\\t"; break;
+      default:
+        if (c < 0x20) {
+          char escape[8];
+          std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+          quoted += escape;
+        } else {
+          quoted += static_cast<char>(c);
+        }
+    }
+  }
+  return quoted + "\"";
+}
+
+// Read a string value, decoding escape sequences (\uXXXX to UTF-8)
+inline bool JsonGetString(const std::string& json, const std::string& key, std::string& value) {
+  std::string::size_type p = JsonFindValue(json, key);
+  if (p == std::string::npos || json[p] != '"') {
+    return false;
+  }
+  std::string decoded;
+  for (std::string::size_type i = p + 1; i < json.size(); i++) {
+    char c = json[i];
+    if (c == '"') {
+      value = decoded;
+      return true;
+    }
+    if (c != '\\') {
+      decoded += c;
+      continue;
+    }
+    if (++i == json.size()) {
+      return false;
+    }
+    switch (json[i]) {
+      case 'b': decoded += '\b'; break;
+      case 'f': decoded += '\f'; break;
+      case 'n': decoded += '\n'; break;
+      case 'r': decoded += '\r'; break;
+      case 't': decoded += '\t'; break;
+      case 'u': {
+        if (i + 4 >= json.size()) {
+          return false;
+        }
+        unsigned long code = std::strtoul(json.substr(i + 1, 4).c_str(), nullptr, 16);
+        i += 4;
+        if (code < 0x80) {
+          decoded += static_cast<char>(code);
+        } else if (code < 0x800) {
+          decoded += static_cast<char>(0xc0 | (code >> 6));
+          decoded += static_cast<char>(0x80 | (code & 0x3f));
+        } else {
+          decoded += static_cast<char>(0xe0 | (code >> 12));
+          decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+          decoded += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        break;
+      }
+      default: decoded += json[i];
+    }
+  }
+  return false;
+}
+
+// Read a nested object or array value verbatim, including its brackets
+inline bool JsonGetRaw(const std::string& json, const std::string& key, std::string& value) {
+  std::string::size_type p = JsonFindValue(json, key);
+  if (p == std::string::npos || (json[p] != '{' && json[p] != '[')) {
+    return false;
+  }
+  int depth = 0;
+  bool inString = false;
+  for (std::string::size_type i = p; i < json.size(); i++) {
+    char c = json[i];
+    if (inString) {
+      if (c == '\\') {
+        i++;
+      } else if (c == '"') {
+        inString = false;
+      }
+    } else if (c == '"') {
+      inString = true;
+    } else if (c == '{' || c == '[') {
+      depth++;
+    } else if ((c == '}' || c == ']') && --depth == 0) {
+      value = json.substr(p, i - p + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace ns3
+
+#endif /* NR_SIM_JSON_H */
@@ -0,0 +1,118 @@
+/*
+ * Distributed (MPI) execution of multi-cell nr-simulation runs.
+ *
+ * ns-3's distributed simulators need the same node ids on every rank, so
+ * every rank builds the whole topology. Each node belongs to one rank
+ * through its system id, and only that rank runs the node's applications
+ * and measurements. Cells are dealt out by site in contiguous blocks, so a
+ * site's sectors and most of its neighbours share a rank. Each UE goes with
+ * its serving cell. The EPC core (SGW, PGW, MME) lives on rank 0, and every
+ * gNB reaches it over its S1-U point-to-point link. Those links, and X2,
+ * are therefore the only links between ranks, and their delay sets the
+ * lookahead.
+ *
+ * Radio channels never cross ranks. Every rank still simulates the PHY of
+ * remote cells, but their user data only flows on the owning rank, so
+ * interference from cells on other ranks is limited to their control
+ * transmissions.
+ *
+ * After Simulator::Run() the flow totals, latency histograms and per-rank
+ * counters are reduced onto rank 0, which alone writes the results. The
+ * reductions are collective and must run on every rank, outside events.
+ */
+
+#ifndef NR_SIM_MPI_H
+#define NR_SIM_MPI_H
+
+#include "nr-sim-flow-collector.h"
+#include "nr-sim-histogram.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#ifdef NS3_MPI
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+class MpiPartition {
+public:
+  MpiPartition(uint32_t rank, uint32_t ranks)
+    : m_rank(rank),
+      m_ranks(ranks > 0 ? ranks : 1) {}
+
+  uint32_t GetRank() const { return m_rank; }
+  uint32_t GetRanks() const { return m_ranks; }
+  bool IsDistributed() const { return m_ranks > 1; }
+
+  // Rank owning every cell of site out of sites
+  uint32_t GetSiteRank(uint32_t site, uint32_t sites) const {
+    return sites > 0 ? static_cast<uint32_t>(uint64_t(site) * m_ranks / sites) : 0;
+  }
+
+#ifdef NS3_MPI
+  // Sum flow totals over all ranks into rank 0's copy
+  void ReduceTotals(FlowTotals& totals) const {
+    int64_t values[5] = {int64_t(totals.txPackets), int64_t(totals.rxBytes), int64_t(totals.rxPackets),
+                         totals.delaySumNs, int64_t(totals.lostPackets)};
+    int64_t sums[5] = {};
+    MPI_Reduce(values, sums, 5, MPI_INT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (m_rank == 0) {
+      totals.txPackets = sums[0];
+      totals.rxBytes = sums[1];
+      totals.rxPackets = sums[2];
+      totals.delaySumNs = sums[3];
+      totals.lostPackets = sums[4];
+    }
+  }
+
+  // Merge every rank's latency histogram into rank 0's
+  void MergeHistogram(LatencyHistogram& histogram) const {
+    std::vector<std::string> sketches = Gather(histogram.ToJson());
+    for (uint32_t r = 1; r < sketches.size(); r++) {
+      LatencyHistogram other;
+      if (other.FromJson(sketches[r])) {
+        histogram.Merge(other);
+      }
+    }
+  }
+
+  // Sum a counter over all ranks into rank 0's copy
+  void ReduceSum(uint64_t& value) const {
+    uint64_t sum = 0;
+    MPI_Reduce(&value, &sum, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (m_rank == 0) {
+      value = sum;
+    }
+  }
+
+  // Every rank's string on rank 0 (index = rank); empty elsewhere
+  std::vector<std::string> Gather(const std::string& local) const {
+    int length = local.size();
+    std::vector<int> lengths(m_rank == 0 ? m_ranks : 0);
+    MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    std::vector<int> offsets(lengths.size());
+    int total = 0;
+    for (uint32_t r = 0; r < lengths.size(); r++) {
+      offsets[r] = total;
+      total += lengths[r];
+    }
+    std::vector<char> buffer(total);
+    MPI_Gatherv(local.data(), length, MPI_CHAR, buffer.data(), lengths.data(), offsets.data(), MPI_CHAR, 0,
+                MPI_COMM_WORLD);
+    std::vector<std::string> all;
+    for (uint32_t r = 0; r < lengths.size(); r++) {
+      all.emplace_back(buffer.data() + offsets[r], lengths[r]);
+    }
+    return all;
+  }
+#endif
+
+private:
+  uint32_t m_rank;
+  uint32_t m_ranks;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_MPI_H */
@@ -0,0 +1,322 @@
+/*
+ * Content-addressed on-disk result cache for nr-simulation.
+ *
+ * A cache directory holds one file per result, named after the 64-bit
+ * FNV-1a hash of its canonical key, plus a fixed-size `index` file that
+ * every process maps shared:
+ *
+ *   Header                     64 bytes
+ *   Slot[kSlots]               24 bytes each, open addressing on the hash
+ *
+ * Each result file starts with the full key on its own line, so a hash
+ * collision reads as a miss, and an entry whose file is missing or holds
+ * another key is dropped. Inserts write a temporary file and rename it into
+ * place; the rename and all index reads and updates happen under flock() on
+ * the index, which makes concurrent nr-simulation processes safe. When the
+ * stored bytes exceed the configured bound, or the table fills up, the
+ * least recently used entries are evicted. If the header's counters claim
+ * entries the table does not hold, eviction rebuilds them from the slots
+ * whose files still exist.
+ */
+
+#ifndef NR_SIM_RESULT_CACHE_H
+#define NR_SIM_RESULT_CACHE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+class ResultCache {
+public:
+  static const uint32_t kVersion = 1;
+  static const uint32_t kSlots = 4096;
+  static const uint64_t kEmpty = 0;      // Slot never used
+  static const uint64_t kTombstone = 1;  // Slot freed by eviction
+
+  struct Header {
+    char magic[4];          // "NRRC"
+    uint32_t version;
+    uint32_t slots;
+    uint32_t entries;
+    uint32_t tombstones;
+    uint32_t reserved;
+    uint64_t clock;         // Logical time of the last access
+    uint64_t bytes;         // Total size of the result files
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+  };
+
+  struct Slot {
+    uint64_t hash;          // kEmpty, kTombstone or a key hash
+    uint64_t bytes;
+    uint64_t lastUsed;      // Header clock at the last hit or insert
+  };
+
+  ~ResultCache() { Close(); }
+
+  // FNV-1a, moved clear of the two reserved slot markers
+  static uint64_t Hash(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+      hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash <= kTombstone ? hash + 2 : hash;
+  }
+
+  // Open (creating if needed) the cache directory and map its index
+  bool Open(const std::string& dir, uint64_t maxBytes) {
+    Close();
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+    m_dir = dir;
+    m_maxBytes = maxBytes;
+    m_fd = open((dir + "/index").c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+      return false;
+    }
+    const size_t size = sizeof(Header) + kSlots * sizeof(Slot);
+    Lock lock(m_fd);
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || (st.st_size != static_cast<off_t>(size) && ftruncate(m_fd, size) != 0)) {
+      Close();
+      return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (mapped == MAP_FAILED) {
+      Close();
+      return false;
+    }
+    m_header = static_cast<Header*>(mapped);
+    m_slots = reinterpret_cast<Slot*>(m_header + 1);
+    if (std::memcmp(m_header->magic, "NRRC", 4) != 0 || m_header->version != kVersion ||
+        m_header->slots != kSlots) {
+      // New or incompatible index: start empty (stale files get overwritten)
+      std::memset(mapped, 0, size);
+      std::memcpy(m_header->magic, "NRRC", 4);
+      m_header->version = kVersion;
+      m_header->slots = kSlots;
+    }
+    return true;
+  }
+
+  bool IsOpen() const { return m_header != nullptr; }
+
+  void Close() {
+    if (m_header != nullptr) {
+      munmap(m_header, sizeof(Header) + kSlots * sizeof(Slot));
+      m_header = nullptr;
+      m_slots = nullptr;
+    }
+    if (m_fd >= 0) {
+      close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+  // Fetch the payload stored under key; counts a hit or a miss
+  bool Lookup(const std::string& key, std::string& payload) {
+    uint64_t hash = Hash(key);
+    Lock lock(m_fd);
+    Slot* slot = Find(hash);
+    std::string stored;
+    if (slot != nullptr && ReadFile(PathOf(hash), stored) && stored.compare(0, key.size(), key) == 0 &&
+        stored.size() > key.size() && stored[key.size()] == '\n') {
+      slot->lastUsed = ++m_header->clock;
+      m_header->hits++;
+      payload = stored.substr(key.size() + 1);
+      return true;
+    }
+    if (slot != nullptr) {
+      // The file went missing or holds another key: drop the stale entry
+      m_header->bytes -= slot->bytes;
+      m_header->entries--;
+      m_header->tombstones++;
+      slot->hash = kTombstone;
+    }
+    m_header->misses++;
+    return false;
+  }
+
+  // Store payload under key, then evict down to the configured bounds
+  bool Insert(const std::string& key, const std::string& payload) {
+    uint64_t hash = Hash(key);
+    std::string path = PathOf(hash);
+    std::string temp = path + ".tmp." + std::to_string(getpid());
+    std::ofstream out(temp, std::ios::binary);
+    out << key << '\n' << payload;
+    out.close();
+    uint64_t bytes = key.size() + 1 + payload.size();
+
+    // Rename under the lock so the file and its slot change together
+    Lock lock(m_fd);
+    if (!out || std::rename(temp.c_str(), path.c_str()) != 0) {
+      std::remove(temp.c_str());
+      return false;
+    }
+    Slot* slot = Find(hash);
+    if (slot != nullptr) {
+      m_header->bytes -= slot->bytes;
+    } else {
+      slot = FindFree(hash);
+      if (slot->hash == kTombstone) {
+        m_header->tombstones--;
+      }
+      m_header->entries++;
+    }
+    slot->hash = hash;
+    slot->bytes = bytes;
+    slot->lastUsed = ++m_header->clock;
+    m_header->bytes += bytes;
+    Evict(slot);
+    return true;
+  }
+
+  std::string StatsToJson() {
+    Lock lock(m_fd);
+    std::ostringstream out;
+    out << "{\"entries\": " << m_header->entries << ", \"bytes\": " << m_header->bytes
+        << ", \"hits\": " << m_header->hits << ", \"misses\": " << m_header->misses
+        << ", \"evictions\": " << m_header->evictions << "}";
+    return out.str();
+  }
+
+private:
+  // Exclusive flock() for the lifetime of the object
+  struct Lock {
+    explicit Lock(int fd) : m_fd(fd) { flock(m_fd, LOCK_EX); }
+    ~Lock() { flock(m_fd, LOCK_UN); }
+    int m_fd;
+  };
+
+  std::string PathOf(uint64_t hash) const {
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.json", static_cast<unsigned long long>(hash));
+    return m_dir + "/" + name;
+  }
+
+  static bool ReadFile(const std::string& path, std::string& contents) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    return true;
+  }
+
+  Slot* Find(uint64_t hash) {
+    for (uint32_t i = 0, s = hash % kSlots; i < kSlots; i++, s = (s + 1) % kSlots) {
+      if (m_slots[s].hash == hash) {
+        return &m_slots[s];
+      }
+      if (m_slots[s].hash == kEmpty) {
+        return nullptr;
+      }
+    }
+    return nullptr;
+  }
+
+  // First reusable slot on hash's probe path; eviction keeps one available
+  Slot* FindFree(uint64_t hash) {
+    for (uint32_t i = 0, s = hash % kSlots; i < kSlots; i++, s = (s + 1) % kSlots) {
+      if (m_slots[s].hash <= kTombstone) {
+        return &m_slots[s];
+      }
+    }
+    return &m_slots[hash % kSlots];
+  }
+
+  // Drop least recently used entries (never `keep`) while over the byte
+  // bound or 3/4 full, then compact if tombstones lengthen the probes
+  void Evict(const Slot* keep) {
+    const uint64_t keepHash = keep->hash;
+    bool rebuilt = false;
+    while (m_header->entries > 1 &&
+           (m_header->bytes > m_maxBytes || m_header->entries > kSlots * 3 / 4)) {
+      Slot* victim = nullptr;
+      for (uint32_t s = 0; s < kSlots; s++) {
+        Slot* candidate = &m_slots[s];
+        if (candidate->hash > kTombstone && candidate->hash != keepHash &&
+            (victim == nullptr || candidate->lastUsed < victim->lastUsed)) {
+          victim = candidate;
+        }
+      }
+      if (victim == nullptr) {
+        // The counters claim entries no slot holds: the index is corrupt
+        if (rebuilt) {
+          break;
+        }
+        Rebuild();
+        rebuilt = true;
+        continue;
+      }
+      std::remove(PathOf(victim->hash).c_str());
+      m_header->bytes -= victim->bytes;
+      m_header->entries--;
+      m_header->tombstones++;
+      m_header->evictions++;
+      victim->hash = kTombstone;
+    }
+    if (m_header->tombstones > kSlots / 4) {
+      std::vector<Slot> live;
+      for (uint32_t s = 0; s < kSlots; s++) {
+        if (m_slots[s].hash > kTombstone) {
+          live.push_back(m_slots[s]);
+        }
+      }
+      Compact(live);
+    }
+  }
+
+  // Recount entries and bytes from the slots whose result files still
+  // exist, dropping the rest, and compact the table
+  void Rebuild() {
+    std::vector<Slot> live;
+    uint64_t bytes = 0;
+    for (uint32_t s = 0; s < kSlots; s++) {
+      struct stat st;
+      if (m_slots[s].hash > kTombstone && stat(PathOf(m_slots[s].hash).c_str(), &st) == 0) {
+        live.push_back(m_slots[s]);
+        live.back().bytes = st.st_size;
+        bytes += st.st_size;
+      }
+    }
+    Compact(live);
+    m_header->entries = live.size();
+    m_header->bytes = bytes;
+  }
+
+  // Refill the table with just the live slots
+  void Compact(const std::vector<Slot>& live) {
+    std::memset(m_slots, 0, kSlots * sizeof(Slot));
+    for (const Slot& slot : live) {
+      *FindFree(slot.hash) = slot;
+    }
+    m_header->tombstones = 0;
+  }
+
+  std::string m_dir;
+  uint64_t m_maxBytes = 0;
+  int m_fd = -1;
+  Header* m_header = nullptr;
+  Slot* m_slots = nullptr;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_RESULT_CACHE_H */
@@ -0,0 +1,144 @@
+/*
+ * Full-buffer downlink source for capacity measurements.
+ *
+ * A UdpClient sends at a fixed rate (1500 B per ms is 12 Mb/s), so it caps
+ * whatever the carrier could carry. SaturatingSource instead keeps a fixed
+ * number of bytes in flight towards its UE: it sends until Window bytes are
+ * outstanding and tops the window up again each time the sink reports a
+ * delivery. With the window above the per-UE bandwidth-delay product the
+ * gNB's RLC queue never runs dry, and the measured rate is the capacity of
+ * the cell rather than the offered load.
+ *
+ * Payloads are zero-filled, which ns-3 represents by size without storing
+ * any bytes, so a packet costs no more than its buffer for the SeqTsHeader.
+ * The sink's deliveries carry that header's sequence number: a gap means
+ * the packets in between were dropped (in RLC or on the air), and their
+ * bytes go back to the window at once. Losses at the end of a burst leave
+ * no later delivery to reveal them, so bytes that are neither delivered
+ * nor heard of within StaleTimeout are written off as well, and the window
+ * cannot leak shut. The accounting lives in InFlightWindow.
+ */
+
+#ifndef NR_SIM_SATURATING_SOURCE_H
+#define NR_SIM_SATURATING_SOURCE_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "nr-sim-saturating-window.h"
+#include <cstdint>
+
+namespace ns3 {
+
+class SaturatingSource : public Application {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid =
+      TypeId("ns3::SaturatingSource")
+        .SetParent<Application>()
+        .SetGroupName("Applications")
+        .AddConstructor<SaturatingSource>()
+        .AddAttribute("RemoteAddress", "IPv4 address of the receiving UE", AddressValue(),
+                      MakeAddressAccessor(&SaturatingSource::m_peer), MakeAddressChecker())
+        .AddAttribute("RemotePort", "UDP port of the receiving UE", UintegerValue(1000),
+                      MakeUintegerAccessor(&SaturatingSource::m_port), MakeUintegerChecker<uint16_t>())
+        .AddAttribute("PacketSize", "Size of each packet including the SeqTsHeader", UintegerValue(1500),
+                      MakeUintegerAccessor(&SaturatingSource::m_packetSize), MakeUintegerChecker<uint32_t>(12, 65507))
+        .AddAttribute("Window", "Bytes kept in flight towards the UE", UintegerValue(64 * 1024),
+                      MakeUintegerAccessor(&SaturatingSource::m_window), MakeUintegerChecker<uint32_t>())
+        .AddAttribute("StaleTimeout", "Write off in-flight bytes after this long without a delivery",
+                      TimeValue(MilliSeconds(20)),
+                      MakeTimeAccessor(&SaturatingSource::m_staleTimeout), MakeTimeChecker())
+        .AddTraceSource("Tx", "A packet has been sent", MakeTraceSourceAccessor(&SaturatingSource::m_txTrace),
+                        "ns3::Packet::TracedCallback");
+    return tid;
+  }
+
+  // Sink-side feedback: connect to the receiving UdpServer's "Rx" trace,
+  // which fires before the server strips the SeqTsHeader
+  void NotifyDelivered(Ptr<const Packet> packet) {
+    SeqTsHeader header;
+    if (packet->PeekHeader(header) == header.GetSerializedSize()) {
+      m_flight.OnDelivered(header.GetSeq(), packet->GetSize());
+    } else {
+      m_flight.OnDelivered(packet->GetSize());
+    }
+    m_delivered += packet->GetSize();
+    m_lastDelivery = Simulator::Now();
+    TopUp();
+  }
+
+  uint64_t GetSentPackets() const { return m_flight.GetSentPackets(); }
+  uint64_t GetDeliveredBytes() const { return m_delivered; }
+  uint64_t GetLostPackets() const { return m_flight.GetLostPackets(); }
+
+protected:
+  void DoDispose() override {
+    m_socket = nullptr;
+    Application::DoDispose();
+  }
+
+private:
+  void StartApplication() override {
+    if (!m_socket) {
+      m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+      m_socket->Bind();
+      m_socket->Connect(InetSocketAddress(Ipv4Address::ConvertFrom(m_peer), m_port));
+    }
+    m_flight.Configure(m_packetSize, m_window);
+    m_lastDelivery = Simulator::Now();
+    TopUp();
+    m_staleEvent = Simulator::Schedule(m_staleTimeout, &SaturatingSource::CheckStale, this);
+  }
+
+  void StopApplication() override {
+    Simulator::Cancel(m_staleEvent);
+    if (m_socket) {
+      m_socket->Close();
+    }
+  }
+
+  // Send until the window is full or the socket pushes back
+  void TopUp() {
+    while (m_socket && m_flight.CanSend()) {
+      SeqTsHeader header;
+      Ptr<Packet> packet = Create<Packet>(m_packetSize - header.GetSerializedSize());
+      header.SetSeq(static_cast<uint32_t>(m_flight.GetSentPackets()));
+      packet->AddHeader(header);
+      if (m_socket->Send(packet) < 0) {
+        break;
+      }
+      m_txTrace(packet);
+      m_flight.OnSent();
+    }
+  }
+
+  // Bytes lost below the sink never report back; reopen the window
+  void CheckStale() {
+    if (m_flight.GetInFlight() > 0 && Simulator::Now() - m_lastDelivery >= m_staleTimeout) {
+      m_flight.WriteOff();
+      m_lastDelivery = Simulator::Now();
+      TopUp();
+    }
+    m_staleEvent = Simulator::Schedule(m_staleTimeout, &SaturatingSource::CheckStale, this);
+  }
+
+  Address m_peer;
+  uint16_t m_port = 1000;
+  uint32_t m_packetSize = 1500;
+  uint32_t m_window = 64 * 1024;
+  Time m_staleTimeout;
+  Ptr<Socket> m_socket;
+  InFlightWindow m_flight;
+  uint64_t m_delivered = 0;
+  Time m_lastDelivery;
+  EventId m_staleEvent;
+  TracedCallback<Ptr<const Packet>> m_txTrace;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SaturatingSource);
+
+} // namespace ns3
+
+#endif /* NR_SIM_SATURATING_SOURCE_H */
@@ -0,0 +1,71 @@
+/*
+ * In-flight byte accounting for SaturatingSource.
+ * Packets are numbered from 0 as they are sent. A delivery of sequence
+ * number seq also accounts for every skipped packet below it as lost. A
+ * write-off (the source's StaleTimeout) forgets everything sent so far:
+ * those packets may still arrive late, and they must not then be taken out
+ * of the bytes in flight of the packets sent after them. Kept free of
+ * ns-3 so nr-simulation-test can drive it directly.
+ */
+
+#ifndef NR_SIM_SATURATING_WINDOW_H
+#define NR_SIM_SATURATING_WINDOW_H
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ns3 {
+
+class InFlightWindow {
+public:
+  void Configure(uint32_t packetSize, uint32_t window) {
+    m_packetSize = packetSize;
+    m_window = window;
+  }
+
+  // Whether one more packet fits in the window
+  bool CanSend() const { return m_inFlight + m_packetSize <= m_window; }
+
+  // Account for a packet about to go out; returns its sequence number
+  uint64_t OnSent() {
+    m_inFlight += m_packetSize;
+    return m_sent++;
+  }
+
+  // Account for a delivery of size bytes carrying sequence number seq
+  void OnDelivered(uint64_t seq, uint32_t size) {
+    if (seq < m_nextSeq) {
+      // Late arrival of a packet already skipped over or written off
+      return;
+    }
+    m_lost += seq - m_nextSeq;
+    m_inFlight -= std::min<uint64_t>(m_inFlight, (seq - m_nextSeq) * m_packetSize);
+    m_nextSeq = seq + 1;
+    m_inFlight -= std::min<uint64_t>(m_inFlight, size);
+  }
+
+  // Account for a delivery whose sequence number could not be read
+  void OnDelivered(uint32_t size) { m_inFlight -= std::min<uint64_t>(m_inFlight, size); }
+
+  // Give up on everything sent so far and reopen the window
+  void WriteOff() {
+    m_inFlight = 0;
+    m_nextSeq = m_sent;
+  }
+
+  uint64_t GetInFlight() const { return m_inFlight; }
+  uint64_t GetSentPackets() const { return m_sent; }
+  uint64_t GetLostPackets() const { return m_lost; }
+
+private:
+  uint32_t m_packetSize = 1500;
+  uint32_t m_window = 64 * 1024;
+  uint64_t m_sent = 0;
+  uint64_t m_inFlight = 0;
+  uint64_t m_nextSeq = 0; // Sequence number of the next expected delivery
+  uint64_t m_lost = 0;    // Packets skipped over by a later delivery
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_SATURATING_WINDOW_H */
@@ -0,0 +1,131 @@
+/*
+ * Shared-memory result segment for nr-simulation.
+ *
+ * With --shmName the run publishes its result into a POSIX shared memory
+ * object instead of a JSON file. The portal's native addon maps it and
+ * reads the fixed fields and per-flow columns in place; only the optional
+ * result sections are JSON. Everything is little-endian and 8-byte aligned:
+ *
+ *   Header                       96 bytes
+ *   double[flowCount] x 4        rxBytes, rxPackets, delaySumNs, lostPackets
+ *   char[jsonBytes]              {"jobId": ..., <result sections>}
+ *
+ * Header field offsets, for readers without this struct:
+ *
+ *    0 magic "NRSR"      4 version          8 headerBytes     12 flowCount
+ *   16 totalBytes       24 flowsOffset     32 jsonOffset      40 jsonBytes
+ *   48 throughput       56 latency         64 frequency       72 bandwidth
+ *   80 transmitPower    88 tdd             92 reserved
+ *
+ * The object is created exclusively, filled, and its magic stored last, so
+ * a reader that sees "NRSR" sees a complete segment. Completion is then
+ * announced with a {"type": "result", "shm": name} record on stdout. The
+ * reader unlinks the object once mapped; the pages live until it unmaps.
+ */
+
+#ifndef NR_SIM_SHM_RESULT_H
+#define NR_SIM_SHM_RESULT_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+class SharedResult {
+public:
+  static const uint32_t kVersion = 1;
+  static const uint32_t kColumns = 4;
+
+  struct Header {
+    char magic[4];          // "NRSR", written last
+    uint32_t version;
+    uint32_t headerBytes;
+    uint32_t flowCount;
+    uint64_t totalBytes;
+    uint64_t flowsOffset;   // kColumns arrays of flowCount doubles
+    uint64_t jsonOffset;
+    uint64_t jsonBytes;
+    double throughput;      // bps
+    double latency;         // s
+    double frequency;       // Hz
+    double bandwidth;       // Hz
+    double transmitPower;   // dBm
+    uint32_t tdd;           // 1 = TDD, 0 = FDD
+    uint32_t reserved;
+  };
+
+  // Segment size for a result with flowCount flows and jsonBytes of JSON
+  static uint64_t Size(uint32_t flowCount, uint64_t jsonBytes) {
+    return sizeof(Header) + uint64_t(kColumns) * flowCount * sizeof(double) + jsonBytes;
+  }
+
+  // Create the shared memory object name (e.g. "/nr-sim-42") and fill it.
+  // columns holds kColumns arrays of header.flowCount values. Returns false
+  // with a message in error and nothing left behind on failure.
+  static bool Publish(const std::string& name, Header header, const std::vector<const double*>& columns,
+                      const std::string& json, std::string& error) {
+    header.headerBytes = sizeof(Header);
+    header.flowsOffset = sizeof(Header);
+    header.jsonOffset = header.flowsOffset + uint64_t(kColumns) * header.flowCount * sizeof(double);
+    header.jsonBytes = json.size();
+    header.totalBytes = Size(header.flowCount, json.size());
+    header.version = kVersion;
+    std::memset(header.magic, 0, sizeof(header.magic));
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      error = "shm_open " + name + ": " + std::strerror(errno);
+      return false;
+    }
+    void* mapped = MAP_FAILED;
+    if (ftruncate(fd, header.totalBytes) == 0) {
+      mapped = mmap(nullptr, header.totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      error = "cannot map " + name + ": " + std::strerror(errno);
+      shm_unlink(name.c_str());
+      return false;
+    }
+
+    char* data = static_cast<char*>(mapped);
+    std::memcpy(data, &header, sizeof(header));
+    for (uint32_t c = 0; c < kColumns; c++) {
+      if (header.flowCount > 0) {
+        std::memcpy(data + header.flowsOffset + uint64_t(c) * header.flowCount * sizeof(double), columns[c],
+                    header.flowCount * sizeof(double));
+      }
+    }
+    std::memcpy(data + header.jsonOffset, json.data(), json.size());
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(data, "NRSR", 4);
+    munmap(mapped, header.totalBytes);
+    return true;
+  }
+
+  // Check that size bytes at data hold a complete version 1 segment
+  static bool Validate(const void* data, uint64_t size) {
+    Header header;
+    if (size < sizeof(Header)) {
+      return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    return std::memcmp(header.magic, "NRSR", 4) == 0 && header.version == kVersion &&
+           header.headerBytes == sizeof(Header) && header.totalBytes <= size &&
+           header.flowsOffset % sizeof(double) == 0 &&
+           header.flowsOffset + uint64_t(kColumns) * header.flowCount * sizeof(double) <= header.jsonOffset &&
+           header.jsonOffset + header.jsonBytes <= header.totalBytes;
+  }
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_SHM_RESULT_H */
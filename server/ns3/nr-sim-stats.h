@@ -0,0 +1,74 @@
+/*
+ * Running sample statistics for independent replications of nr-simulation.
+ */
+
+#ifndef NR_SIM_STATS_H
+#define NR_SIM_STATS_H
+
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace ns3 {
+
+// Two-sided 95% Student-t critical values for 1..30 degrees of freedom
+inline double StudentT95(uint64_t degreesOfFreedom) {
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  if (degreesOfFreedom == 0) {
+    return INFINITY;
+  }
+  if (degreesOfFreedom <= 30) {
+    return table[degreesOfFreedom - 1];
+  }
+  // Normal approximation with a first-order small-sample correction
+  return 1.959964 + 2.37 / degreesOfFreedom;
+}
+
+// Welford accumulator for mean, sample standard deviation and 95% CI
+class SampleStats {
+public:
+  void Add(double value) {
+    m_count++;
+    double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+  }
+
+  uint64_t GetCount() const { return m_count; }
+  double GetMean() const { return m_mean; }
+  double GetStdDev() const { return m_count > 1 ? std::sqrt(m_m2 / (m_count - 1)) : 0.0; }
+
+  // Half-width of the 95% confidence interval of the mean
+  double GetHalfWidth() const {
+    return m_count > 1 ? StudentT95(m_count - 1) * GetStdDev() / std::sqrt(double(m_count)) : INFINITY;
+  }
+
+  // Half-width relative to the mean, the quantity early stopping targets
+  double GetRelativeHalfWidth() const {
+    return m_mean != 0.0 ? GetHalfWidth() / std::fabs(m_mean) : INFINITY;
+  }
+
+  std::string ToJson() const {
+    std::ostringstream out;
+    double hw = GetHalfWidth();
+    out << "{\"mean\": " << m_mean << ", \"stddev\": " << GetStdDev();
+    if (std::isfinite(hw)) {
+      out << ", \"ciLow\": " << m_mean - hw << ", \"ciHigh\": " << m_mean + hw << ", \"halfWidth\": " << hw;
+    }
+    out << "}";
+    return out.str();
+  }
+
+private:
+  uint64_t m_count = 0;
+  double m_mean = 0.0;
+  double m_m2 = 0.0;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_STATS_H */
@@ -0,0 +1,119 @@
+/*
+ * Parameter grids for nr-simulation --sweep: parsing of the sweep spec and
+ * its expansion into points, in cartesian or list mode.
+ */
+
+#ifndef NR_SIM_SWEEP_H
+#define NR_SIM_SWEEP_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// One point of a --sweep grid
+struct SweepPoint {
+  double frequency;
+  double bandwidth;
+  std::string duplexMode;
+  double txPower;
+};
+
+// Split text at separator, dropping empty fields
+inline std::vector<std::string> SplitString(const std::string& text, char separator) {
+  std::vector<std::string> parts;
+  std::string::size_type start = 0;
+  while (start <= text.size()) {
+    std::string::size_type end = text.find(separator, start);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    if (end > start) {
+      parts.push_back(text.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return parts;
+}
+
+// Expand a sweep spec such as "frequency=3.5e9,28e9;bandwidth=20e6,100e6"
+// into points. Parameters not named keep their value in defaults. In
+// "cartesian" mode every combination is produced; in "list" mode the i-th
+// values of each list form point i and single values are broadcast.
+inline std::string ExpandSweep(const std::string& spec, const std::string& mode, const SweepPoint& defaults,
+                               std::vector<SweepPoint>& points) {
+  std::vector<double> frequencies = {defaults.frequency};
+  std::vector<double> bandwidths = {defaults.bandwidth};
+  std::vector<std::string> duplexModes = {defaults.duplexMode};
+  std::vector<double> txPowers = {defaults.txPower};
+
+  for (const std::string& entry : SplitString(spec, ';')) {
+    std::string::size_type eq = entry.find('=');
+    if (eq == std::string::npos) {
+      return "sweep entry '" + entry + "' is not key=v1,v2,...";
+    }
+    std::string key = entry.substr(0, eq);
+    std::vector<std::string> values = SplitString(entry.substr(eq + 1), ',');
+    if (values.empty()) {
+      return "sweep entry '" + key + "' has no values";
+    }
+    if (key == "duplexMode") {
+      for (const std::string& v : values) {
+        if (v != "TDD" && v != "FDD") {
+          return "duplexMode must be TDD or FDD";
+        }
+      }
+      duplexModes = values;
+      continue;
+    }
+    std::vector<double>* target = key == "frequency" ? &frequencies
+                                : key == "bandwidth" ? &bandwidths
+                                : key == "transmitPower" ? &txPowers
+                                : nullptr;
+    if (target == nullptr) {
+      return "unknown sweep parameter '" + key + "'";
+    }
+    target->clear();
+    for (const std::string& v : values) {
+      char* end = nullptr;
+      target->push_back(std::strtod(v.c_str(), &end));
+      if (end == v.c_str() || *end != '\0') {
+        return "sweep value '" + v + "' for " + key + " is not a number";
+      }
+    }
+  }
+
+  points.clear();
+  if (mode == "cartesian") {
+    for (double f : frequencies) {
+      for (double bw : bandwidths) {
+        for (const std::string& dm : duplexModes) {
+          for (double tx : txPowers) {
+            points.push_back({f, bw, dm, tx});
+          }
+        }
+      }
+    }
+  } else if (mode == "list") {
+    size_t n = std::max({frequencies.size(), bandwidths.size(), duplexModes.size(), txPowers.size()});
+    auto fits = [n](size_t size) { return size == 1 || size == n; };
+    if (!fits(frequencies.size()) || !fits(bandwidths.size()) || !fits(duplexModes.size()) || !fits(txPowers.size())) {
+      return "in list mode every sweep parameter needs 1 or " + std::to_string(n) + " values";
+    }
+    for (size_t i = 0; i < n; i++) {
+      points.push_back({frequencies[frequencies.size() == 1 ? 0 : i],
+                        bandwidths[bandwidths.size() == 1 ? 0 : i],
+                        duplexModes[duplexModes.size() == 1 ? 0 : i],
+                        txPowers[txPowers.size() == 1 ? 0 : i]});
+    }
+  } else {
+    return "sweepMode must be cartesian or list";
+  }
+  return "";
+}
+
+} // namespace ns3
+
+#endif /* NR_SIM_SWEEP_H */
@@ -0,0 +1,199 @@
+/*
+ * Fixed-schema, columnar binary time series for nr-simulation.
+ *
+ * Everything is little-endian and 8-byte aligned so readers can mmap the
+ * file and point typed arrays straight at the column blocks:
+ *
+ *   FileHeader                  32 bytes
+ *   ColumnInfo[columnCount]     24 bytes each
+ *   block*                      until end of file
+ *
+ * Each block is a BlockHeader (8 bytes) followed by one contiguous array
+ * per column of `rows` values, each array zero-padded to a multiple of 8
+ * bytes. Counters are cumulative at the sample time, so per-window values
+ * are differences between consecutive rows of the same flow.
+ */
+
+#ifndef NR_SIM_TIMESERIES_H
+#define NR_SIM_TIMESERIES_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class TimeSeriesWriter {
+public:
+  static const uint16_t kVersion = 1;
+  static const uint32_t kBlockRows = 4096;
+
+  enum ColumnType : uint8_t { INT64 = 1, UINT32 = 2, UINT64 = 3 };
+
+  struct FileHeader {
+    char magic[4];         // "NRTS"
+    uint16_t version;
+    uint16_t columnCount;
+    uint32_t blockRows;    // Max rows per block
+    uint32_t reserved;
+    uint64_t totalRows;    // Patched on Close()
+    uint64_t blockCount;   // Patched on Close()
+  };
+
+  struct ColumnInfo {
+    char name[16];         // NUL-padded
+    uint8_t type;          // ColumnType
+    uint8_t width;         // Bytes per value
+    uint8_t reserved[6];
+  };
+
+  struct BlockHeader {
+    uint32_t rows;
+    uint32_t reserved;
+  };
+
+  ~TimeSeriesWriter() { Close(); }
+
+  bool Open(const std::string& path) {
+    Close();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) {
+      return false;
+    }
+    m_totalRows = 0;
+    m_blockCount = 0;
+    WriteHeader();
+    static const ColumnInfo columns[] = {
+      {"timestampNs", INT64, 8, {}},
+      {"flowId", UINT32, 4, {}},
+      {"rxBytes", UINT64, 8, {}},
+      {"rxPackets", UINT64, 8, {}},
+      {"delaySumNs", INT64, 8, {}},
+      {"lostPackets", UINT64, 8, {}},
+    };
+    for (const ColumnInfo& column : columns) {
+      WriteRaw(column);
+    }
+    m_timestampNs.reserve(kBlockRows);
+    m_flowId.reserve(kBlockRows);
+    m_rxBytes.reserve(kBlockRows);
+    m_rxPackets.reserve(kBlockRows);
+    m_delaySumNs.reserve(kBlockRows);
+    m_lostPackets.reserve(kBlockRows);
+    return true;
+  }
+
+  bool IsOpen() const { return m_file != nullptr; }
+
+  void Append(int64_t timestampNs, uint32_t flowId, uint64_t rxBytes, uint64_t rxPackets,
+              int64_t delaySumNs, uint64_t lostPackets) {
+    m_timestampNs.push_back(timestampNs);
+    m_flowId.push_back(flowId);
+    m_rxBytes.push_back(rxBytes);
+    m_rxPackets.push_back(rxPackets);
+    m_delaySumNs.push_back(delaySumNs);
+    m_lostPackets.push_back(lostPackets);
+    if (m_flowId.size() == kBlockRows) {
+      FlushBlock();
+    }
+  }
+
+  // Flush the partial block and patch the row/block counts into the header
+  void Close() {
+    if (m_file == nullptr) {
+      return;
+    }
+    FlushBlock();
+    std::fseek(m_file, 0, SEEK_SET);
+    WriteHeader();
+    std::fclose(m_file);
+    m_file = nullptr;
+  }
+
+  uint64_t GetTotalRows() const { return m_totalRows + m_flowId.size(); }
+
+private:
+  static bool HostIsLittleEndian() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+  }
+
+  // Header structs are filled with little-endian values before writing
+  template <class T>
+  void WriteRaw(const T& value) {
+    std::fwrite(&value, sizeof(T), 1, m_file);
+  }
+
+  void WriteHeader() {
+    FileHeader header;
+    std::memcpy(header.magic, "NRTS", 4);
+    header.version = ToLe16(kVersion);
+    header.columnCount = ToLe16(6);
+    header.blockRows = ToLe32(kBlockRows);
+    header.reserved = 0;
+    header.totalRows = ToLe64(m_totalRows);
+    header.blockCount = ToLe64(m_blockCount);
+    WriteRaw(header);
+  }
+
+  template <class T>
+  void WriteColumn(const std::vector<T>& values) {
+    if (HostIsLittleEndian()) {
+      std::fwrite(values.data(), sizeof(T), values.size(), m_file);
+    } else {
+      for (T v : values) {
+        T le = sizeof(T) == 4 ? static_cast<T>(ToLe32(v)) : static_cast<T>(ToLe64(v));
+        std::fwrite(&le, sizeof(T), 1, m_file);
+      }
+    }
+    static const uint8_t zeros[8] = {};
+    size_t bytes = values.size() * sizeof(T);
+    std::fwrite(zeros, 1, (8 - bytes % 8) % 8, m_file);
+  }
+
+  void FlushBlock() {
+    if (m_flowId.empty()) {
+      return;
+    }
+    BlockHeader block;
+    block.rows = ToLe32(m_flowId.size());
+    block.reserved = 0;
+    WriteRaw(block);
+    WriteColumn(m_timestampNs);
+    WriteColumn(m_flowId);
+    WriteColumn(m_rxBytes);
+    WriteColumn(m_rxPackets);
+    WriteColumn(m_delaySumNs);
+    WriteColumn(m_lostPackets);
+    m_totalRows += m_flowId.size();
+    m_blockCount++;
+    m_timestampNs.clear();
+    m_flowId.clear();
+    m_rxBytes.clear();
+    m_rxPackets.clear();
+    m_delaySumNs.clear();
+    m_lostPackets.clear();
+  }
+
+  static uint16_t ToLe16(uint16_t v) {
+    return HostIsLittleEndian() ? v : static_cast<uint16_t>((v >> 8) | (v << 8));
+  }
+  static uint32_t ToLe32(uint32_t v) { return HostIsLittleEndian() ? v : __builtin_bswap32(v); }
+  static uint64_t ToLe64(uint64_t v) { return HostIsLittleEndian() ? v : __builtin_bswap64(v); }
+
+  std::FILE* m_file = nullptr;
+  uint64_t m_totalRows = 0;
+  uint64_t m_blockCount = 0;
+  std::vector<int64_t> m_timestampNs;
+  std::vector<uint32_t> m_flowId;
+  std::vector<uint64_t> m_rxBytes;
+  std::vector<uint64_t> m_rxPackets;
+  std::vector<int64_t> m_delaySumNs;
+  std::vector<uint64_t> m_lostPackets;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_TIMESERIES_H */
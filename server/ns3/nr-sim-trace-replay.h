@@ -0,0 +1,250 @@
+/*
+ * Trace-driven traffic for nr-simulation.
+ *
+ * A packet arrival trace is a little-endian binary file that is mapped
+ * read-only and used in place:
+ *
+ *   FileHeader                   24 bytes
+ *   Record[recordCount]          16 bytes each, sorted by time
+ *
+ * TraceReplay walks the mapping with a cursor and schedules the next
+ * kLookahead records at a time; the last event of a chunk schedules the
+ * next one. Pending events and resident memory therefore stay constant
+ * however long the trace is, and opening a trace costs the same for any
+ * size. Pages already replayed are released with MADV_DONTNEED.
+ *
+ * Each downlink record becomes one packet of the record's size (including
+ * the SeqTsHeader) sent by the TraceReplaySource of that UE. Uplink records
+ * and records for UEs outside the topology are counted and skipped. Under
+ * MPI, each rank replays only the records of its own UEs and ignores the
+ * rest, so its replayed counts cover only its own UEs and are summed onto
+ * rank 0. Skipped counts are the same on every rank.
+ */
+
+#ifndef NR_SIM_TRACE_REPLAY_H
+#define NR_SIM_TRACE_REPLAY_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+// Sends the packets TraceReplay hands it to one UE
+class TraceReplaySource : public Application {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid =
+      TypeId("ns3::TraceReplaySource")
+        .SetParent<Application>()
+        .SetGroupName("Applications")
+        .AddConstructor<TraceReplaySource>()
+        .AddAttribute("RemoteAddress", "IPv4 address of the receiving UE", AddressValue(),
+                      MakeAddressAccessor(&TraceReplaySource::m_peer), MakeAddressChecker())
+        .AddAttribute("RemotePort", "UDP port of the receiving UE", UintegerValue(1000),
+                      MakeUintegerAccessor(&TraceReplaySource::m_port), MakeUintegerChecker<uint16_t>())
+        .AddTraceSource("Tx", "A packet has been sent", MakeTraceSourceAccessor(&TraceReplaySource::m_txTrace),
+                        "ns3::Packet::TracedCallback");
+    return tid;
+  }
+
+  void Send(uint32_t size, uint32_t seq) {
+    if (!m_socket) {
+      return;
+    }
+    SeqTsHeader header;
+    header.SetSeq(seq);
+    Ptr<Packet> packet = Create<Packet>(size - std::min(size, header.GetSerializedSize()));
+    packet->AddHeader(header);
+    if (m_socket->Send(packet) >= 0) {
+      m_txTrace(packet);
+    }
+  }
+
+protected:
+  void DoDispose() override {
+    m_socket = nullptr;
+    Application::DoDispose();
+  }
+
+private:
+  void StartApplication() override {
+    if (!m_socket) {
+      m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+      m_socket->Bind();
+      m_socket->Connect(InetSocketAddress(Ipv4Address::ConvertFrom(m_peer), m_port));
+    }
+  }
+
+  void StopApplication() override {
+    if (m_socket) {
+      m_socket->Close();
+      m_socket = nullptr;
+    }
+  }
+
+  Address m_peer;
+  uint16_t m_port = 1000;
+  Ptr<Socket> m_socket;
+  TracedCallback<Ptr<const Packet>> m_txTrace;
+};
+
+class TraceReplay {
+public:
+  static const uint32_t kVersion = 1;
+  static const uint32_t kLookahead = 256;  // Records scheduled per chunk
+
+  enum Direction : uint8_t { DOWNLINK = 0, UPLINK = 1 };
+
+  struct FileHeader {
+    char magic[4];          // "NRTR"
+    uint32_t version;
+    uint64_t recordCount;
+    uint32_t ues;           // Highest UE index + 1 in the trace
+    uint32_t reserved;
+  };
+
+  struct Record {
+    uint64_t timeNs;        // Arrival time from the start of the run
+    uint32_t size;          // Packet size in bytes
+    uint16_t ue;            // UE index in nr-simulation's node order
+    uint8_t direction;      // DOWNLINK or UPLINK
+    uint8_t reserved;
+  };
+
+  ~TraceReplay() { Close(); }
+
+  // Map a trace file; returns false with a message in error
+  bool Open(const std::string& path, std::string& error) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+      error = "cannot open " + path;
+      if (fd >= 0) {
+        close(fd);
+      }
+      return false;
+    }
+    m_size = st.st_size;
+    void* mapped = m_size >= sizeof(FileHeader) ? mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      error = path + " is not a trace file";
+      return false;
+    }
+    m_mapped = static_cast<const char*>(mapped);
+    madvise(mapped, m_size, MADV_SEQUENTIAL);
+    FileHeader header;
+    std::memcpy(&header, m_mapped, sizeof(header));
+    if (std::memcmp(header.magic, "NRTR", 4) != 0 || header.version != kVersion ||
+        header.recordCount > (m_size - sizeof(FileHeader)) / sizeof(Record)) {
+      error = path + " is not a valid NRTR version 1 file";
+      Close();
+      return false;
+    }
+    m_records = reinterpret_cast<const Record*>(m_mapped + sizeof(FileHeader));
+    m_count = header.recordCount;
+    return true;
+  }
+
+  void Close() {
+    if (m_mapped != nullptr) {
+      munmap(const_cast<char*>(m_mapped), m_size);
+      m_mapped = nullptr;
+    }
+    m_records = nullptr;
+    m_count = 0;
+    m_next = 0;
+    m_released = 0;
+  }
+
+  bool IsOpen() const { return m_mapped != nullptr; }
+
+  struct Stats {
+    uint64_t replayed = 0;
+    uint64_t skipped = 0;
+    uint64_t bytes = 0;
+  };
+
+  // Replay the trace from now on; records for UE u are sent by sources[u].
+  // sources covers every UE, with null entries for UEs on other ranks.
+  void Start(const std::vector<Ptr<TraceReplaySource>>& sources) {
+    m_sources = sources;
+    m_next = 0;
+    Simulator::ScheduleNow(&TraceReplay::ScheduleChunk, this);
+  }
+
+  std::string StatsToJson() const {
+    std::ostringstream out;
+    out << "{\"records\": " << m_count << ", \"replayed\": " << m_stats.replayed << ", \"skipped\": "
+        << m_stats.skipped << ", \"bytes\": " << m_stats.bytes << "}";
+    return out.str();
+  }
+
+  Stats& GetStats() { return m_stats; }
+
+private:
+  // Schedule the next chunk of records; the chunk's last event calls back
+  void ScheduleChunk() {
+    uint64_t end = std::min<uint64_t>(m_next + kLookahead, m_count);
+    int64_t now = Simulator::Now().GetNanoSeconds();
+    for (uint64_t i = m_next; i < end; i++) {
+      int64_t at = std::max<int64_t>(static_cast<int64_t>(m_records[i].timeNs), now);
+      Simulator::Schedule(NanoSeconds(at - now), &TraceReplay::Replay, this, i, i + 1 == end);
+    }
+    Release(m_next);
+    m_next = end;
+  }
+
+  void Replay(uint64_t i, bool lastOfChunk) {
+    const Record& r = m_records[i];
+    if (r.direction != DOWNLINK || r.ue >= m_sources.size()) {
+      m_stats.skipped++;
+    } else if (m_sources[r.ue]) {
+      m_sources[r.ue]->Send(r.size, static_cast<uint32_t>(i));
+      m_stats.replayed++;
+      m_stats.bytes += r.size;
+    }
+    if (lastOfChunk && m_next < m_count) {
+      ScheduleChunk();
+    }
+  }
+
+  // Drop whole pages below record i from the resident set
+  void Release(uint64_t i) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t offset = sizeof(FileHeader) + i * sizeof(Record);
+    size_t done = offset / page * page;
+    if (done > m_released) {
+      madvise(const_cast<char*>(m_mapped) + m_released, done - m_released, MADV_DONTNEED);
+      m_released = done;
+    }
+  }
+
+  const char* m_mapped = nullptr;
+  size_t m_size = 0;
+  size_t m_released = 0;
+  const Record* m_records = nullptr;
+  uint64_t m_count = 0;
+  uint64_t m_next = 0;
+  Stats m_stats;
+  std::vector<Ptr<TraceReplaySource>> m_sources;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(TraceReplaySource);
+
+} // namespace ns3
+
+#endif /* NR_SIM_TRACE_REPLAY_H */
@@ -0,0 +1,148 @@
+/*
+ * Bounded pool of forked worker processes for nr-simulation.
+ * ns-3's Simulator is a process-wide singleton, so parallel runs have to be
+ * separate processes. Each job runs in a fresh child forked from a parent
+ * that has never touched the Simulator, and hands its output back through a
+ * pipe.
+ */
+
+#ifndef NR_SIM_WORKER_POOL_H
+#define NR_SIM_WORKER_POOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+// Number of online cores, used when no explicit worker count is given
+inline uint32_t DefaultWorkerCount() {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? static_cast<uint32_t>(cores) : 1;
+}
+
+class WorkerPool {
+public:
+  explicit WorkerPool(uint32_t maxWorkers)
+    : m_maxWorkers(maxWorkers > 0 ? maxWorkers : DefaultWorkerCount()) {}
+
+  ~WorkerPool() {
+    for (Worker& w : m_workers) {
+      close(w.fd);
+      waitpid(w.pid, nullptr, 0);
+    }
+  }
+
+  uint32_t GetMaxWorkers() const { return m_maxWorkers; }
+  uint32_t GetRunning() const { return m_workers.size(); }
+  bool IsFull() const { return m_workers.size() >= m_maxWorkers; }
+
+  // Fork a child that runs job() and sends its return value back.
+  // The caller must not launch while IsFull(); returns false if fork fails.
+  bool Launch(uint64_t tag, const std::function<std::string()>& job) {
+    int fds[2];
+    if (pipe(fds) < 0) {
+      return false;
+    }
+    // Don't let children inherit (and later re-flush) buffered parent output
+    std::cout.flush();
+    std::fflush(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+      close(fds[0]);
+      close(fds[1]);
+      return false;
+    }
+    if (pid == 0) {
+      close(fds[0]);
+      for (Worker& w : m_workers) {
+        close(w.fd);
+      }
+      std::string output = job();
+      const char* data = output.data();
+      size_t left = output.size();
+      while (left > 0) {
+        ssize_t n = write(fds[1], data, left);
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        if (n <= 0) {
+          break;
+        }
+        data += n;
+        left -= n;
+      }
+      close(fds[1]);
+      _exit(0);
+    }
+
+    close(fds[1]);
+    m_workers.push_back({pid, fds[0], tag, ""});
+    return true;
+  }
+
+  // Block until one running job finishes. Returns false when nothing is
+  // running. exitStatus is the raw waitpid status of the child.
+  bool WaitOne(uint64_t& tag, std::string& output, int& exitStatus) {
+    if (m_workers.empty()) {
+      return false;
+    }
+    std::vector<pollfd> fds(m_workers.size());
+    while (true) {
+      for (size_t i = 0; i < m_workers.size(); i++) {
+        fds[i] = {m_workers[i].fd, POLLIN, 0};
+      }
+      if (poll(fds.data(), fds.size(), -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      for (size_t i = 0; i < m_workers.size(); i++) {
+        if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+          continue;
+        }
+        char buf[8192];
+        ssize_t n = read(m_workers[i].fd, buf, sizeof(buf));
+        if (n > 0) {
+          m_workers[i].output.append(buf, n);
+          continue;
+        }
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        // EOF: the child is done
+        Worker done = m_workers[i];
+        m_workers.erase(m_workers.begin() + i);
+        close(done.fd);
+        waitpid(done.pid, &exitStatus, 0);
+        tag = done.tag;
+        output = done.output;
+        return true;
+      }
+    }
+  }
+
+private:
+  struct Worker {
+    pid_t pid;
+    int fd;
+    uint64_t tag;
+    std::string output;
+  };
+
+  uint32_t m_maxWorkers;
+  std::vector<Worker> m_workers;
+};
+
+} // namespace ns3
+
+#endif /* NR_SIM_WORKER_POOL_H */
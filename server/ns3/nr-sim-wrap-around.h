@@ -0,0 +1,197 @@
+/*
+ * Wrap-around for the hexagonal multi-site layout.
+ *
+ * A complete-ring cluster tiles the plane with six copies of itself (see
+ * HexTopology::GetWrapAroundShifts()). Under wrap-around every UE-gNB link
+ * uses the copy of the UE nearest to the gNB, so cells at the edge of the
+ * cluster see a full ring of interferers, the same as the centre cell.
+ *
+ * UEs get a WrapAroundMobilityModel. It reports the UE's real position,
+ * except inside a WrapAroundImage scope opened for one link, where it
+ * reports the mirrored copy instead. WrapAroundPropagationLossModel wraps
+ * the spectrum channel's pathloss chain, and WrapAroundThreeGppChannelModel
+ * wraps fast-fading generation, in such a scope. Pathloss, the LOS
+ * condition and the cluster angles therefore all see the same mirrored
+ * geometry, while node ids, and so every per-link cache, stay real. Only
+ * the propagation delay still uses the real distance, at most a few
+ * microseconds off.
+ */
+
+#ifndef NR_SIM_WRAP_AROUND_H
+#define NR_SIM_WRAP_AROUND_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/spectrum-module.h"
+#include <cmath>
+#include <vector>
+
+namespace ns3 {
+
+class WrapAroundMobilityModel : public MobilityModel {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::WrapAroundMobilityModel")
+                          .SetParent<MobilityModel>()
+                          .SetGroupName("Mobility")
+                          .AddConstructor<WrapAroundMobilityModel>();
+    return tid;
+  }
+
+  // Offsets of the six copies of the cluster; empty turns mirroring off
+  static void SetShifts(const std::vector<Vector>& shifts) { GetShifts() = shifts; }
+  static bool IsEnabled() { return !GetShifts().empty(); }
+
+  // Offset that moves this UE to its copy nearest to point
+  Vector GetShiftTowards(const Vector& point) const {
+    Vector best(0, 0, 0);
+    double bestDistance = std::hypot(m_position.x - point.x, m_position.y - point.y);
+    for (const Vector& shift : GetShifts()) {
+      double distance = std::hypot(m_position.x + shift.x - point.x, m_position.y + shift.y - point.y);
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        best = shift;
+      }
+    }
+    return best;
+  }
+
+private:
+  friend class WrapAroundImage;
+
+  static std::vector<Vector>& GetShifts() {
+    static std::vector<Vector> shifts;
+    return shifts;
+  }
+
+  Vector DoGetPosition() const override {
+    return Vector(m_position.x + m_shift.x, m_position.y + m_shift.y, m_position.z);
+  }
+
+  void DoSetPosition(const Vector& position) override {
+    m_position = position;
+    NotifyCourseChange();
+  }
+
+  Vector DoGetVelocity() const override { return Vector(0, 0, 0); }
+
+  Vector m_position;
+  mutable Vector m_shift;  // Non-zero only inside a WrapAroundImage scope
+};
+
+NS_OBJECT_ENSURE_REGISTERED(WrapAroundMobilityModel);
+
+// Moves the UE end of link (a, b) to its copy nearest the other end for
+// the lifetime of the scope. A link without a WrapAroundMobilityModel end
+// is left alone.
+class WrapAroundImage {
+public:
+  WrapAroundImage(Ptr<const MobilityModel> a, Ptr<const MobilityModel> b) {
+    m_ue = DynamicCast<const WrapAroundMobilityModel>(b);
+    Ptr<const MobilityModel> other = a;
+    if (!m_ue) {
+      m_ue = DynamicCast<const WrapAroundMobilityModel>(a);
+      other = b;
+    }
+    if (!m_ue || !WrapAroundMobilityModel::IsEnabled()) {
+      m_ue = nullptr;
+      return;
+    }
+    m_saved = m_ue->m_shift;
+    m_ue->m_shift = m_ue->GetShiftTowards(other->GetPosition());
+  }
+
+  ~WrapAroundImage() {
+    if (m_ue) {
+      m_ue->m_shift = m_saved;
+    }
+  }
+
+  WrapAroundImage(const WrapAroundImage&) = delete;
+  WrapAroundImage& operator=(const WrapAroundImage&) = delete;
+
+private:
+  Ptr<const WrapAroundMobilityModel> m_ue;
+  Vector m_saved;
+};
+
+// Head of a spectrum channel's pathloss chain that runs the original chain
+// on the mirrored link
+class WrapAroundPropagationLossModel : public PropagationLossModel {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::WrapAroundPropagationLossModel")
+                          .SetParent<PropagationLossModel>()
+                          .SetGroupName("Propagation")
+                          .AddConstructor<WrapAroundPropagationLossModel>();
+    return tid;
+  }
+
+  // Put the channel's current pathloss chain behind a wrap-around model.
+  // Returns false if the channel has no pathloss model or is already
+  // wrapped.
+  static bool Install(Ptr<SpectrumChannel> channel) {
+    Ptr<PropagationLossModel> inner = channel->GetPropagationLossModel();
+    if (!inner || DynamicCast<WrapAroundPropagationLossModel>(inner)) {
+      return false;
+    }
+    Ptr<WrapAroundPropagationLossModel> wrapper = CreateObject<WrapAroundPropagationLossModel>();
+    wrapper->m_inner = inner;
+    channel->AddPropagationLossModel(wrapper);
+    // AddPropagationLossModel() chains the old head after the new one; it
+    // is called from DoCalcRxPower() instead, so it must not run twice
+    wrapper->SetNext(nullptr);
+    return true;
+  }
+
+private:
+  double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override {
+    WrapAroundImage image(a, b);
+    return m_inner->CalcRxPower(txPowerDbm, a, b);
+  }
+
+  int64_t DoAssignStreams(int64_t stream) override { return m_inner->AssignStreams(stream); }
+
+  Ptr<PropagationLossModel> m_inner;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(WrapAroundPropagationLossModel);
+
+// ThreeGppChannelModel that generates each link's channel, and the channel
+// condition it draws, on the mirrored link
+class WrapAroundThreeGppChannelModel : public ThreeGppChannelModel {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::WrapAroundThreeGppChannelModel")
+                          .SetParent<ThreeGppChannelModel>()
+                          .SetGroupName("Spectrum")
+                          .AddConstructor<WrapAroundThreeGppChannelModel>();
+    return tid;
+  }
+
+  WrapAroundThreeGppChannelModel() { GetInstances()++; }
+
+  // Instances created so far (subclasses included); 0 means the spectrum
+  // model never picked up this TypeId and fast fading is not mirrored
+  static uint32_t GetInstanceCount() { return GetInstances(); }
+
+  Ptr<const ChannelMatrix> GetChannel(Ptr<const MobilityModel> aMob, Ptr<const MobilityModel> bMob,
+                                      Ptr<const PhasedArrayModel> aAntenna,
+                                      Ptr<const PhasedArrayModel> bAntenna) override {
+    WrapAroundImage image(aMob, bMob);
+    return ThreeGppChannelModel::GetChannel(aMob, bMob, aAntenna, bAntenna);
+  }
+
+private:
+  static uint32_t& GetInstances() {
+    static uint32_t instances = 0;
+    return instances;
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED(WrapAroundThreeGppChannelModel);
+
+} // namespace ns3
+
+#endif /* NR_SIM_WRAP_AROUND_H */
@@ -0,0 +1,499 @@
+/*
+ * Scaling benchmark for the RAN Portal 5G NR simulation.
+ * Runs nr-simulation over a fixed matrix of scenarios (UE count, bandwidth,
+ * numerology, duplex mode, simulated length, beamforming) and records
+ * wall-clock time per simulated second, events per second, peak RSS, and
+ * startup, setup and run time for each. Scenarios that run through a cold
+ * or warm --beamCacheDir or --channelCacheDir also report their total wall
+ * time against the same scenario run without the cache, and a warm channel
+ * cache must reproduce the cold run's per-flow results bit for bit.
+ * Results are written as JSON; with --baseline they are compared against
+ * an earlier results file and any regression makes the exit status
+ * non-zero.
+ */
+
+#include "ns3/core-module.h"
+#include "nr-sim-json.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <map>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+using namespace ns3;
+NS_LOG_COMPONENT_DEFINE("NrSimulationBench");
+
+// Benchmark parameter defaults
+std::string gSimulator = "build/scratch/ns3.43-nr-simulation-default"; // nr-simulation binary
+std::string gOutputPath = "nr-simulation-bench.json";  // Results file
+std::string gBaselinePath = "";  // Earlier results file to compare against
+std::string gFilter = "";        // Only run scenarios whose name contains this
+uint32_t gRepeat = 3;            // Runs per scenario; medians are reported
+double gThreshold = 0.1;         // Relative change that counts as a regression
+
+// Times below this are dominated by noise and are not compared
+const double kMinComparableTime = 0.05;
+
+// One point of the fixed scenario matrix. Names are the keys baselines are
+// matched on, so they must stay stable once published.
+struct Scenario {
+  std::string name;
+  uint32_t sites;          // 0 = single gNB/UE link, else 3-sector sites
+  uint32_t uesPerCell;
+  double bandwidth;
+  uint16_t numerology;
+  std::string duplexMode;
+  double simTime;
+  std::string traffic;     // cbr or saturating
+  std::string flowProbe;   // flowmonitor or endpoint
+  uint32_t probeSampling;  // Endpoint probe reads 1 in N packets
+  std::string beamforming; // default or cellScan
+  std::string cache;       // none, or beams or channels in a cold or warm cache directory
+  std::string uncached;    // Scenario a cached one is compared with ("" = none)
+};
+
+static const std::vector<Scenario> kScenarios = {
+  {"single-link", 0, 1, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"base", 1, 4, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"ues-60", 1, 20, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"ues-294", 7, 14, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"bw-100mhz", 1, 4, 100e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"mu-0", 1, 4, 20e6, 0, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"mu-3", 1, 4, 20e6, 3, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"fdd", 1, 4, 20e6, 1, "FDD", 0.5, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"long-2s", 1, 4, 20e6, 1, "TDD", 2.0, "cbr", "flowmonitor", 1, "default", "none", ""},
+  {"saturating", 1, 4, 20e6, 1, "TDD", 0.5, "saturating", "flowmonitor", 1, "default", "none", ""},
+  {"saturating-100mhz", 1, 4, 100e6, 1, "TDD", 0.5, "saturating", "flowmonitor", 1, "default", "none", ""},
+  {"ues-294-endpoint", 7, 14, 20e6, 1, "TDD", 0.5, "cbr", "endpoint", 1, "default", "none", ""},
+  {"ues-294-sampled", 7, 14, 20e6, 1, "TDD", 0.5, "cbr", "endpoint", 16, "default", "none", ""},
+  {"channels-cold", 1, 4, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "channels-cold", "base"},
+  {"channels-warm", 1, 4, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "channels-warm", "base"},
+  {"channels-ues-60-cold", 1, 20, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "channels-cold", "ues-60"},
+  {"channels-ues-60-warm", 1, 20, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "default", "channels-warm", "ues-60"},
+  {"cellscan", 1, 4, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "none", ""},
+  {"cellscan-cold", 1, 4, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "beams-cold", "cellscan"},
+  {"cellscan-warm", 1, 4, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "beams-warm", "cellscan"},
+  {"cellscan-ues-60", 1, 20, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "none", ""},
+  {"cellscan-ues-60-cold", 1, 20, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "beams-cold", "cellscan-ues-60"},
+  {"cellscan-ues-60-warm", 1, 20, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "beams-warm", "cellscan-ues-60"},
+  {"cellscan-ues-294", 7, 14, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "none", ""},
+  {"cellscan-ues-294-cold", 7, 14, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "beams-cold", "cellscan-ues-294"},
+  {"cellscan-ues-294-warm", 7, 14, 20e6, 1, "TDD", 0.5, "cbr", "flowmonitor", 1, "cellScan", "beams-warm", "cellscan-ues-294"},
+};
+
+// Measurements of one scenario
+struct BenchResult {
+  double wallTime = 0;     // Whole process, start to exit
+  double startupTime = 0;  // Process wall time outside setup and the event loop
+  double setupTime = 0;
+  double runTime = 0;
+  double simTime = 0;
+  double events = 0;
+  long peakRssKb = 0;
+};
+
+// Median of a non-empty sample
+static double Median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t n = values.size();
+  return n % 2 == 1 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+static bool IsCold(const Scenario& s) {
+  return s.cache.size() > 5 && s.cache.compare(s.cache.size() - 5, 5, "-cold") == 0;
+}
+
+static bool IsWarm(const Scenario& s) {
+  return s.cache.size() > 5 && s.cache.compare(s.cache.size() - 5, 5, "-warm") == 0;
+}
+
+// Empty cache directory for one scenario; "" on failure
+static std::string MakeCacheDir() {
+  char path[] = "/tmp/nr-simulation-bench-cache-XXXXXX";
+  if (mkdtemp(path) == nullptr) {
+    NS_LOG_ERROR("Cannot create a temporary cache directory");
+    return "";
+  }
+  return path;
+}
+
+static void RemoveCacheDir(const std::string& path) {
+  if (path.empty()) {
+    return;
+  }
+  if (DIR* dir = opendir(path.c_str())) {
+    while (dirent* entry = readdir(dir)) {
+      if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+        unlink((path + "/" + entry->d_name).c_str());
+      }
+    }
+    closedir(dir);
+  }
+  rmdir(path.c_str());
+}
+
+static std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  return buffer.str();
+}
+
+// Run nr-simulation once for a scenario and collect its own timeline plus
+// the peak RSS the kernel reports for the child. A non-empty cacheDir is
+// passed as the scenario's cache directory. With flows set, the run also
+// writes its per-flow time series, which is returned in flows followed by
+// the results block. Returns false on failure.
+static bool RunOnce(const Scenario& scenario, const std::string& cacheDir, BenchResult& result,
+                    std::string* flows = nullptr) {
+  char resultPath[] = "/tmp/nr-simulation-bench-XXXXXX.json";
+  int fd = mkstemps(resultPath, 5);
+  if (fd < 0) {
+    NS_LOG_ERROR("Cannot create a temporary results file");
+    return false;
+  }
+  close(fd);
+
+  // Steady-state stopping is disabled so every run covers the full length
+  std::vector<std::string> args = {
+    gSimulator,
+    "--sites=" + std::to_string(scenario.sites),
+    "--sectorsPerSite=3",
+    "--uesPerCell=" + std::to_string(scenario.uesPerCell),
+    "--bandwidth=" + std::to_string(scenario.bandwidth),
+    "--numerology=" + std::to_string(scenario.numerology),
+    "--duplexMode=" + scenario.duplexMode,
+    "--traffic=" + scenario.traffic,
+    "--flowProbe=" + scenario.flowProbe,
+    "--probeSampling=" + std::to_string(scenario.probeSampling),
+    "--maxSimTime=" + std::to_string(scenario.simTime),
+    "--stableWindows=4294967295",
+    "--outputPath=" + std::string(resultPath),
+  };
+  if (scenario.beamforming == "cellScan") {
+    args.push_back("--beamforming=cellScan");
+  }
+  if (!cacheDir.empty()) {
+    args.push_back((scenario.cache.compare(0, 6, "beams-") == 0 ? "--beamCacheDir=" : "--channelCacheDir=") +
+                   cacheDir);
+  }
+  std::string seriesPath = std::string(resultPath) + ".nrts";
+  if (flows != nullptr) {
+    args.push_back("--timeSeriesPath=" + seriesPath);
+  }
+  std::vector<char*> argv;
+  for (std::string& arg : args) {
+    argv.push_back(&arg[0]);
+  }
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid;
+  int err = posix_spawn(&pid, gSimulator.c_str(), &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (err != 0) {
+    NS_LOG_ERROR("Cannot start " << gSimulator << ": " << std::strerror(err));
+    std::remove(resultPath);
+    return false;
+  }
+
+  int status = 0;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    NS_LOG_ERROR("Scenario " << scenario.name << " failed with status " << status);
+    std::remove(resultPath);
+    std::remove(seriesPath.c_str());
+    return false;
+  }
+  double processTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::string json = ReadFile(resultPath);
+  std::remove(resultPath);
+  if (flows != nullptr) {
+    std::string results;
+    JsonGetRaw(json, "results", results);
+    *flows = ReadFile(seriesPath) + results;
+    std::remove(seriesPath.c_str());
+  }
+  std::string timeline;
+  std::string topology;
+  if (!JsonGetRaw(json, "timeline", timeline) || !JsonGetRaw(json, "topology", topology) ||
+      !JsonGetNumber(timeline, "wallTime", result.runTime) ||
+      !JsonGetNumber(timeline, "simTime", result.simTime) ||
+      !JsonGetNumber(timeline, "events", result.events) ||
+      !JsonGetNumber(topology, "setupTime", result.setupTime)) {
+    NS_LOG_ERROR("Scenario " << scenario.name << " wrote incomplete results");
+    return false;
+  }
+  // Exec, dynamic linking, static initialization, parsing and teardown
+  result.wallTime = processTime;
+  result.startupTime = std::max(0.0, processTime - result.setupTime - result.runTime);
+  result.peakRssKb = usage.ru_maxrss;
+  return true;
+}
+
+// Repeat a scenario gRepeat times: median times, worst-case RSS. A cold
+// cache starts empty on every run; a warm one is filled by one untimed run
+// first and shared by the timed ones. A warm channel cache then gets one
+// more untimed run whose per-flow results must match the filling run's.
+static bool RunScenario(const Scenario& scenario, BenchResult& result) {
+  const bool checkFlows = scenario.cache == "channels-warm";
+  std::string warmDir;
+  std::string coldFlows;
+  if (IsWarm(scenario)) {
+    BenchResult filling;
+    warmDir = MakeCacheDir();
+    if (warmDir.empty() || !RunOnce(scenario, warmDir, filling, checkFlows ? &coldFlows : nullptr)) {
+      RemoveCacheDir(warmDir);
+      return false;
+    }
+  }
+  std::vector<double> wallTimes;
+  std::vector<double> startupTimes;
+  std::vector<double> setupTimes;
+  std::vector<double> runTimes;
+  for (uint32_t i = 0; i < gRepeat; i++) {
+    std::string cacheDir = warmDir;
+    if (IsCold(scenario)) {
+      cacheDir = MakeCacheDir();
+      if (cacheDir.empty()) {
+        return false;
+      }
+    }
+    BenchResult run;
+    bool ok = RunOnce(scenario, cacheDir, run);
+    if (IsCold(scenario)) {
+      RemoveCacheDir(cacheDir);
+    }
+    if (!ok) {
+      RemoveCacheDir(warmDir);
+      return false;
+    }
+    wallTimes.push_back(run.wallTime);
+    startupTimes.push_back(run.startupTime);
+    setupTimes.push_back(run.setupTime);
+    runTimes.push_back(run.runTime);
+    result.simTime = run.simTime;
+    result.events = run.events;
+    result.peakRssKb = std::max(result.peakRssKb, run.peakRssKb);
+  }
+  if (checkFlows) {
+    BenchResult check;
+    std::string warmFlows;
+    bool ok = RunOnce(scenario, warmDir, check, &warmFlows);
+    if (ok && (coldFlows.empty() || warmFlows != coldFlows)) {
+      NS_LOG_ERROR("Scenario " << scenario.name << ": the warm run's per-flow results differ from the cold run's");
+      ok = false;
+    }
+    if (!ok) {
+      RemoveCacheDir(warmDir);
+      return false;
+    }
+  }
+  RemoveCacheDir(warmDir);
+  result.wallTime = Median(wallTimes);
+  result.startupTime = Median(startupTimes);
+  result.setupTime = Median(setupTimes);
+  result.runTime = Median(runTimes);
+  return true;
+}
+
+static double WallPerSimSecond(const BenchResult& r) {
+  return r.simTime > 0 ? r.runTime / r.simTime : 0.0;
+}
+
+static double EventsPerSecond(const BenchResult& r) {
+  return r.runTime > 0 ? r.events / r.runTime : 0.0;
+}
+
+// JSON object for one scenario: its parameters followed by its measurements,
+// and for a cached scenario the wall time of its uncached one when measured
+static std::string ScenarioJson(const Scenario& s, const BenchResult* r, const BenchResult* uncached) {
+  std::ostringstream out;
+  out << "{\"sites\": " << s.sites << ", \"uesPerCell\": " << s.uesPerCell
+      << ", \"bandwidth\": " << s.bandwidth << ", \"numerology\": " << s.numerology
+      << ", \"duplexMode\": \"" << s.duplexMode << "\", \"simTime\": " << s.simTime
+      << ", \"traffic\": \"" << s.traffic << "\", \"flowProbe\": \"" << s.flowProbe
+      << "\", \"probeSampling\": " << s.probeSampling << ", \"beamforming\": \"" << s.beamforming
+      << "\", \"cache\": \"" << s.cache << "\"";
+  if (r == nullptr) {
+    out << ", \"failed\": true}";
+    return out.str();
+  }
+  out << ", \"wallTime\": " << r->wallTime << ", \"startupTime\": " << r->startupTime << ", \"setupTime\": " << r->setupTime << ", \"runTime\": " << r->runTime
+      << ", \"events\": " << static_cast<uint64_t>(r->events)
+      << ", \"wallPerSimSecond\": " << WallPerSimSecond(*r)
+      << ", \"eventsPerSecond\": " << EventsPerSecond(*r)
+      << ", \"peakRssKb\": " << r->peakRssKb;
+  if (uncached != nullptr && uncached->wallTime > 0) {
+    out << ", \"uncached\": \"" << s.uncached << "\", \"uncachedWallTime\": " << uncached->wallTime
+        << ", \"wallTimeChange\": " << r->wallTime / uncached->wallTime - 1;
+  }
+  out << "}";
+  return out.str();
+}
+
+// Compare one scenario against its baseline entry and append regressions
+// as JSON objects. Returns the number of regressions found.
+static uint32_t CompareScenario(const std::string& name, const std::string& current,
+                                const std::string& baseline, std::vector<std::string>& regressions) {
+  struct Metric {
+    const char* key;
+    bool higherIsWorse;
+    bool isTime;
+  };
+  static const Metric metrics[] = {
+    {"wallPerSimSecond", true, true},
+    {"startupTime", true, true},
+    {"setupTime", true, true},
+    {"eventsPerSecond", false, false},
+    {"peakRssKb", true, false},
+  };
+  uint32_t found = 0;
+  for (const Metric& m : metrics) {
+    double before = 0;
+    double after = 0;
+    if (!JsonGetNumber(baseline, m.key, before) || !JsonGetNumber(current, m.key, after) || before <= 0) {
+      continue;
+    }
+    if (m.isTime && before < kMinComparableTime && after < kMinComparableTime) {
+      continue;
+    }
+    double change = after / before - 1;
+    bool regressed = m.higherIsWorse ? change > gThreshold : change < -gThreshold;
+    std::printf("  %-14s %-18s %12.4g -> %-12.4g %+7.1f%%%s\n", name.c_str(), m.key, before, after,
+                change * 100, regressed ? "  REGRESSION" : "");
+    if (regressed) {
+      std::ostringstream out;
+      out << "{\"scenario\": \"" << name << "\", \"metric\": \"" << m.key << "\", \"baseline\": "
+          << before << ", \"current\": " << after << ", \"change\": " << change << "}";
+      regressions.push_back(out.str());
+      found++;
+    }
+  }
+  return found;
+}
+
+int main(int argc, char *argv[]) {
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("simulator", "Path of the built nr-simulation binary", gSimulator);
+  cmd.AddValue("outputPath", "Path for the benchmark results JSON file", gOutputPath);
+  cmd.AddValue("baseline", "Earlier results file to compare against", gBaselinePath);
+  cmd.AddValue("filter", "Only run scenarios whose name contains this string", gFilter);
+  cmd.AddValue("repeat", "Runs per scenario; medians are reported", gRepeat);
+  cmd.AddValue("threshold", "Relative change that counts as a regression", gThreshold);
+  cmd.Parse(argc, argv);
+
+  LogComponentEnable("NrSimulationBench", LOG_LEVEL_INFO);
+
+  std::string baseline;
+  if (!gBaselinePath.empty()) {
+    std::ifstream in(gBaselinePath);
+    if (!in) {
+      NS_LOG_ERROR("Cannot read baseline " << gBaselinePath);
+      return 2;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    if (!JsonGetRaw(buffer.str(), "scenarios", baseline)) {
+      NS_LOG_ERROR("Baseline " << gBaselinePath << " has no scenarios");
+      return 2;
+    }
+  }
+
+  gRepeat = std::max<uint32_t>(gRepeat, 1);
+  std::vector<std::pair<std::string, std::string>> results;
+  std::map<std::string, BenchResult> measured;
+  uint32_t failures = 0;
+  for (const Scenario& scenario : kScenarios) {
+    if (!gFilter.empty() && scenario.name.find(gFilter) == std::string::npos) {
+      continue;
+    }
+    NS_LOG_INFO("Running " << scenario.name << " (" << gRepeat << "x)");
+    BenchResult result;
+    bool ok = RunScenario(scenario, result);
+    failures += ok ? 0 : 1;
+    auto uncached = measured.find(scenario.uncached);
+    results.emplace_back(scenario.name, ScenarioJson(scenario, ok ? &result : nullptr,
+                                                     uncached != measured.end() ? &uncached->second : nullptr));
+    if (ok) {
+      measured[scenario.name] = result;
+      NS_LOG_INFO("  " << WallPerSimSecond(result) << " s/sim-s, " << EventsPerSecond(result)
+                  << " events/s, startup " << result.startupTime << " s, setup " << result.setupTime << " s, peak RSS " << result.peakRssKb << " kB");
+    }
+  }
+
+  // Cached scenarios list after the uncached one they are compared with
+  bool cacheHeader = false;
+  for (const Scenario& scenario : kScenarios) {
+    auto cached = measured.find(scenario.name);
+    auto uncached = measured.find(scenario.uncached);
+    if (cached == measured.end() || uncached == measured.end() || uncached->second.wallTime <= 0) {
+      continue;
+    }
+    if (!cacheHeader) {
+      std::printf("Cached against uncached runs (median wall time)\n");
+      cacheHeader = true;
+    }
+    double before = uncached->second.wallTime;
+    double after = cached->second.wallTime;
+    std::printf("  %-22s %9.3f s -> %9.3f s %+7.1f%%  (%+.3f s)\n", scenario.name.c_str(), before, after,
+                (after / before - 1) * 100, after - before);
+  }
+
+  std::vector<std::string> regressions;
+  if (!baseline.empty()) {
+    std::printf("Comparison against %s (threshold %.0f%%)\n", gBaselinePath.c_str(), gThreshold * 100);
+    for (const auto& entry : results) {
+      std::string before;
+      if (JsonGetRaw(baseline, entry.first, before)) {
+        CompareScenario(entry.first, entry.second, before, regressions);
+      } else {
+        std::printf("  %-14s not in baseline\n", entry.first.c_str());
+      }
+    }
+  }
+
+  std::ofstream out(gOutputPath);
+  out << "{\n  \"simulator\": \"" << gSimulator << "\",\n  \"repeat\": " << gRepeat
+      << ",\n  \"scenarios\": {";
+  for (size_t i = 0; i < results.size(); i++) {
+    out << (i > 0 ? "," : "") << "\n    \"" << results[i].first << "\": " << results[i].second;
+  }
+  out << "\n  }";
+  if (!baseline.empty()) {
+    out << ",\n  \"comparison\": {\"baseline\": \"" << gBaselinePath << "\", \"threshold\": " << gThreshold
+        << ", \"regressions\": [";
+    for (size_t i = 0; i < regressions.size(); i++) {
+      out << (i > 0 ? ", " : "") << regressions[i];
+    }
+    out << "]}";
+  }
+  out << "\n}\n";
+  out.close();
+
+  NS_LOG_INFO("Results written to " << gOutputPath);
+  if (failures > 0 || !regressions.empty()) {
+    NS_LOG_WARN(failures << " failed scenarios, " << regressions.size() << " regressions");
+    return 1;
+  }
+  return 0;
+}
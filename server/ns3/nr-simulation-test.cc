@@ -0,0 +1,507 @@
+/*
+ * Unit tests for the header-only nr-simulation helpers that do not need
+ * ns-3: sweep grid expansion, the replication statistics, the flow
+ * statistics collector, the latency histogram's quantile error bound, the
+ * scalar versus AVX2 analytic kernels and the on-disk result cache index.
+ *
+ *   nr-simulation-test [sweep|stats|flow-stats|histogram|analytic|result-cache]...
+ *
+ * With no arguments every test runs. The exit status is the number of
+ * failed checks, so CMakeLists.txt registers one ctest per test name. In
+ * the scratch build it runs as `./ns3 run "nr-simulation-test"`.
+ */
+
+#include "nr-sim-analytic.h"
+#include "nr-sim-flow-collector.h"
+#include "nr-sim-histogram.h"
+#include "nr-sim-json.h"
+#include "nr-sim-result-cache.h"
+#include "nr-sim-saturating-window.h"
+#include "nr-sim-stats.h"
+#include "nr-sim-sweep.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+static uint32_t gFailures = 0;
+
+#define CHECK(condition)                                                        \
+  do {                                                                          \
+    if (!(condition)) {                                                         \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,     \
+                   #condition);                                                 \
+      gFailures++;                                                              \
+    }                                                                           \
+  } while (0)
+
+#define CHECK_NEAR(actual, expected, relative)                                  \
+  do {                                                                          \
+    double a_ = (actual);                                                       \
+    double e_ = (expected);                                                     \
+    if (!(std::fabs(a_ - e_) <= (relative) * std::fabs(e_))) {                  \
+      std::fprintf(stderr, "%s:%d: %s = %.17g, expected %.17g (+/- %g)\n",      \
+                   __FILE__, __LINE__, #actual, a_, e_, (relative));            \
+      gFailures++;                                                              \
+    }                                                                           \
+  } while (0)
+
+// Deterministic uniform [0, 1) samples, so failures reproduce
+class Lcg {
+public:
+  explicit Lcg(uint64_t seed) : m_state(seed) {}
+  double Next() {
+    m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (m_state >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+private:
+  uint64_t m_state;
+};
+
+// Stand-ins for ns-3's Time and FlowMonitor::FlowStats with the fields
+// FlowStatsCollector::Sync() reads
+struct FakeTime {
+  int64_t ns;
+  int64_t GetNanoSeconds() const { return ns; }
+};
+
+struct FakeFlowStats {
+  FakeTime delaySum = {0};
+  FakeTime timeFirstTxPacket = {0};
+  FakeTime timeLastRxPacket = {0};
+  uint64_t rxBytes = 0;
+  uint32_t txPackets = 0;
+  uint32_t rxPackets = 0;
+  uint32_t lostPackets = 0;
+};
+
+static FakeFlowStats MakeFlowStats(uint32_t tx, uint32_t rx, int64_t delaySumNs, uint32_t lost,
+                                   int64_t lastRxNs) {
+  FakeFlowStats s;
+  s.txPackets = tx;
+  s.rxPackets = rx;
+  s.rxBytes = rx * 1000ULL;
+  s.delaySum.ns = delaySumNs;
+  s.lostPackets = lost;
+  s.timeLastRxPacket.ns = lastRxNs;
+  return s;
+}
+
+// Each Sync() folds only what changed since the previous one into the
+// totals, flows can appear between syncs, and the mean delay is weighted by
+// packets rather than averaged over flows
+static void TestFlowStats() {
+  FlowStatsCollector collector;
+  collector.Reserve(2);
+  std::map<uint32_t, FakeFlowStats> monitor;
+  monitor[1] = MakeFlowStats(10, 10, 10000000, 0, 1000000000);  // 10 x 1 ms
+  monitor[2] = MakeFlowStats(1, 1, 10000000, 0, 500000000);     // 1 x 10 ms
+  collector.Sync(monitor);
+  const FlowTotals first = collector.GetTotals();
+  CHECK(collector.GetNFlows() == 2);
+  CHECK(first.txPackets == 11 && first.rxPackets == 11 && first.rxBytes == 11000);
+  CHECK(first.delaySumNs == 20000000 && first.lostPackets == 0);
+  CHECK_NEAR(first.GetMeanDelay(), 0.020 / 11, 1e-12);  // Not (1 + 10) / 2 ms
+
+  // Syncing unchanged counters adds nothing
+  collector.Sync(monitor);
+  CHECK(collector.GetTotals().rxPackets == 11 && collector.GetTotals().delaySumNs == 20000000);
+
+  // Flow 1 moves on, flow 2 stays idle and flow 4 appears, leaving the
+  // never-seen flow 3 at zero
+  monitor[1] = MakeFlowStats(20, 19, 19000000, 1, 2000000000);
+  monitor[4] = MakeFlowStats(5, 4, 40000000, 1, 2000000000);
+  monitor[4].timeFirstTxPacket.ns = 1000000000;
+  collector.Sync(monitor);
+  FlowTotals window = collector.GetTotals() - first;
+  CHECK(collector.GetNFlows() == 4);
+  CHECK(window.txPackets == 15 && window.rxPackets == 13 && window.rxBytes == 13000);
+  CHECK(window.delaySumNs == 49000000 && window.lostPackets == 2);
+  CHECK_NEAR(window.GetMeanDelay(), 0.049 / 13, 1e-12);
+  // Flow i lives at index i - 1
+  CHECK(collector.GetRxPackets(1) == 1 && collector.GetRxBytes(1) == 1000);
+  CHECK(collector.GetRxPackets(2) == 0 && collector.GetDelaySumNs(2) == 0);
+  CHECK(collector.GetRxPackets(0) == 19 && collector.GetLostPackets(3) == 1);
+
+  // Each flow's rate over its own first-tx to last-rx span: 19 kB in 2 s,
+  // 1 kB in 0.5 s and 4 kB in 1 s
+  CHECK_NEAR(collector.GetActiveThroughput(), 76000.0 + 16000.0 + 32000.0, 1e-12);
+  CHECK(FlowTotals().GetMeanDelay() == 0.0);
+
+  // EndpointProbe's direct feeds keep the same totals
+  FlowStatsCollector probe;
+  probe.AddFlow(1);
+  CHECK(probe.GetNFlows() == 2);
+  probe.AddTx(1, 100);
+  probe.AddTx(1, 200);
+  probe.AddRx(1, 1500, 1, 3000000, 3000100);
+  probe.SetLost(1, 1);
+  probe.SetLost(1, 1);
+  CHECK(probe.GetTotals().txPackets == 2 && probe.GetTotals().rxBytes == 1500);
+  CHECK(probe.GetTotals().lostPackets == 1);
+  CHECK_NEAR(probe.GetTotals().GetMeanDelay(), 0.003, 1e-12);
+  CHECK_NEAR(probe.GetActiveThroughput(), 1500 * 8.0 / 3e-3, 1e-12);
+}
+
+// Gaps and write-offs return bytes to the window, and packets written off
+// by a stall that arrive late are not taken out of later packets' bytes
+static void TestSaturatingWindow() {
+  InFlightWindow flight;
+  flight.Configure(100, 1000);
+  while (flight.CanSend()) {
+    flight.OnSent();
+  }
+  CHECK(flight.GetSentPackets() == 10 && flight.GetInFlight() == 1000);
+
+  // Packet 0 arrives, 1 and 2 are skipped over by 3
+  flight.OnDelivered(0, 100);
+  flight.OnDelivered(3, 100);
+  CHECK(flight.GetLostPackets() == 2);
+  CHECK(flight.GetInFlight() == 600);
+
+  // Stall: 4..9 are written off and the window refills with 10..19
+  flight.WriteOff();
+  while (flight.CanSend()) {
+    flight.OnSent();
+  }
+  CHECK(flight.GetSentPackets() == 20 && flight.GetInFlight() == 1000);
+
+  // 4..9 turn up late; the window stays full
+  for (uint64_t seq = 4; seq < 10; seq++) {
+    flight.OnDelivered(seq, 100);
+  }
+  CHECK(flight.GetInFlight() == 1000 && !flight.CanSend());
+  CHECK(flight.GetLostPackets() == 2);
+
+  // Deliveries of the new packets count from 10, not from 4
+  flight.OnDelivered(10, 100);
+  CHECK(flight.GetInFlight() == 900);
+  flight.OnDelivered(12, 100);
+  CHECK(flight.GetLostPackets() == 3);
+  CHECK(flight.GetInFlight() == 700);
+
+  // A delivery without a readable sequence number frees its own bytes only
+  flight.OnDelivered(100);
+  CHECK(flight.GetInFlight() == 600);
+}
+
+// Every reported quantile is within kAlpha of the exact order statistic,
+// and merging or serializing a histogram loses nothing
+static void TestHistogram() {
+  Lcg rng(1);
+  std::vector<double> values;
+  LatencyHistogram whole;
+  LatencyHistogram first;
+  LatencyHistogram second;
+  for (int i = 0; i < 20000; i++) {
+    // Log-uniform over 10 us .. 10 s, the range simulated delays cover
+    double value = 1e-5 * std::pow(1e6, rng.Next());
+    values.push_back(value);
+    whole.Record(value);
+    (i % 2 == 0 ? first : second).Record(value);
+  }
+  std::sort(values.begin(), values.end());
+  for (double q : {0.0, 0.1, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+    double exact = values[static_cast<size_t>(q * (values.size() - 1))];
+    CHECK_NEAR(whole.GetQuantile(q), exact, LatencyHistogram::kAlpha * (1 + 1e-9));
+  }
+
+  // Merging adds bucket counts, so only the sum may differ (by rounding)
+  first.Merge(second);
+  CHECK(first.GetCount() == whole.GetCount());
+  CHECK_NEAR(first.GetMean(), whole.GetMean(), 1e-12);
+  for (double q : {0.0, 0.5, 0.99, 1.0}) {
+    CHECK(first.GetQuantile(q) == whole.GetQuantile(q));
+  }
+
+  LatencyHistogram restored;
+  CHECK(restored.FromJson(whole.ToJson()));
+  CHECK(restored.ToJson() == whole.ToJson());
+  CHECK(!restored.FromJson("{\"alpha\": 0.02, \"minValue\": 1e-06, \"count\": 0, \"buckets\": []}"));
+
+  // Reported values never leave the observed [min, max]
+  LatencyHistogram single;
+  single.Record(0.0123);
+  CHECK(single.GetQuantile(0.0) == 0.0123 && single.GetQuantile(1.0) == 0.0123);
+  CHECK(LatencyHistogram().GetQuantile(0.5) == 0.0);
+}
+
+// Welford mean and variance, and the Student-t 95% interval
+static void TestStats() {
+  SampleStats stats;
+  CHECK(std::isinf(stats.GetHalfWidth()));
+  for (double v : {1.0, 2.0, 3.0, 4.0, 5.0}) {
+    stats.Add(v);
+  }
+  CHECK(stats.GetCount() == 5);
+  CHECK_NEAR(stats.GetMean(), 3.0, 1e-15);
+  CHECK_NEAR(stats.GetStdDev(), std::sqrt(2.5), 1e-15);
+  CHECK_NEAR(stats.GetHalfWidth(), 2.776 * std::sqrt(2.5) / std::sqrt(5.0), 1e-12);
+  CHECK_NEAR(stats.GetRelativeHalfWidth(), stats.GetHalfWidth() / 3.0, 1e-15);
+
+  // A large common offset must not cost precision (the naive sum of
+  // squares loses every digit here)
+  SampleStats offset;
+  for (double v : {4.0, 7.0, 13.0, 16.0}) {
+    offset.Add(1e9 + v);
+  }
+  CHECK_NEAR(offset.GetMean(), 1e9 + 10.0, 1e-15);
+  CHECK_NEAR(offset.GetStdDev(), std::sqrt(30.0), 1e-9);
+
+  CHECK(StudentT95(1) == 12.706);
+  CHECK(StudentT95(30) == 2.042);
+  CHECK(StudentT95(31) < StudentT95(30) && StudentT95(1000) > 1.959964);
+  CHECK(std::isinf(StudentT95(0)));
+
+  SampleStats single;
+  single.Add(42);
+  std::string json = single.ToJson();
+  CHECK(json.find("halfWidth") == std::string::npos);
+  double mean = 0;
+  CHECK(JsonGetNumber(json, "mean", mean) && mean == 42);
+}
+
+// Cartesian and list expansion, defaults and every rejected spec
+static void TestSweep() {
+  const SweepPoint defaults = {3.5e9, 20e6, "TDD", 20};
+  std::vector<SweepPoint> points;
+
+  CHECK(ExpandSweep("frequency=3.5e9,28e9;bandwidth=20e6,100e6;duplexMode=TDD,FDD", "cartesian", defaults, points)
+          .empty());
+  CHECK(points.size() == 8);
+  if (points.size() == 8) {
+    CHECK(points[0].frequency == 3.5e9 && points[0].bandwidth == 20e6 && points[0].duplexMode == "TDD");
+    CHECK(points[1].duplexMode == "FDD" && points[1].bandwidth == 20e6);
+    CHECK(points[2].bandwidth == 100e6);
+    CHECK(points[7].frequency == 28e9 && points[7].bandwidth == 100e6 && points[7].duplexMode == "FDD");
+    for (const SweepPoint& p : points) {
+      CHECK(p.txPower == 20);
+    }
+  }
+
+  CHECK(ExpandSweep("", "cartesian", defaults, points).empty());
+  CHECK(points.size() == 1 && points[0].frequency == 3.5e9 && points[0].txPower == 20);
+
+  CHECK(ExpandSweep("frequency=1e9,2e9,3e9;transmitPower=10,20,30;duplexMode=FDD", "list", defaults, points).empty());
+  CHECK(points.size() == 3);
+  if (points.size() == 3) {
+    CHECK(points[2].frequency == 3e9 && points[2].txPower == 30);
+    CHECK(points[0].duplexMode == "FDD" && points[2].duplexMode == "FDD");
+    CHECK(points[1].bandwidth == 20e6);
+  }
+
+  CHECK(!ExpandSweep("frequency=1e9,2e9;bandwidth=1e6,2e6,3e6", "list", defaults, points).empty());
+  CHECK(!ExpandSweep("numerology=1,2", "cartesian", defaults, points).empty());
+  CHECK(!ExpandSweep("frequency=3.5GHz", "cartesian", defaults, points).empty());
+  CHECK(!ExpandSweep("duplexMode=TDD,XDD", "cartesian", defaults, points).empty());
+  CHECK(!ExpandSweep("frequency", "cartesian", defaults, points).empty());
+  CHECK(!ExpandSweep("frequency=", "cartesian", defaults, points).empty());
+  CHECK(!ExpandSweep("frequency=1e9", "random", defaults, points).empty());
+
+  CHECK((SplitString(",a,,b,", ',') == std::vector<std::string>{"a", "b"}));
+}
+
+static double CacheStat(ResultCache& cache, const char* key) {
+  double value = -1;
+  JsonGetNumber(cache.StatsToJson(), key, value);
+  return value;
+}
+
+// Hits, misses, stale entries and least recently used eviction
+static void TestResultCache() {
+  char dir[] = "/tmp/nr-simulation-test-XXXXXX";
+  if (mkdtemp(dir) == nullptr) {
+    CHECK(!"mkdtemp failed");
+    return;
+  }
+  const std::string root = dir;
+  const std::string cacheDir = root + "/cache";
+  auto fileOf = [&cacheDir](const std::string& key) {
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.json", static_cast<unsigned long long>(ResultCache::Hash(key)));
+    return cacheDir + "/" + name;
+  };
+  const std::string payload(100, 'x');
+
+  {
+    ResultCache cache;
+    CHECK(cache.Open(cacheDir, 1 << 20));
+    std::string out;
+    CHECK(!cache.Lookup("a", out));
+    CHECK(cache.Insert("a", payload));
+    CHECK(cache.Lookup("a", out) && out == payload);
+    CHECK(!cache.Lookup("b", out));
+    CHECK(CacheStat(cache, "entries") == 1);
+    CHECK(CacheStat(cache, "bytes") == 2 + payload.size());
+    CHECK(CacheStat(cache, "hits") == 1 && CacheStat(cache, "misses") == 2);
+
+    // Replacing an entry keeps one slot and updates its size
+    CHECK(cache.Insert("a", payload + payload));
+    CHECK(CacheStat(cache, "entries") == 1 && CacheStat(cache, "bytes") == 2 + 2 * payload.size());
+
+    // A file that vanished, or holds another key, frees its slot and bytes
+    std::remove(fileOf("a").c_str());
+    CHECK(!cache.Lookup("a", out));
+    CHECK(CacheStat(cache, "entries") == 0 && CacheStat(cache, "bytes") == 0);
+    CHECK(cache.Insert("c", payload));
+    std::FILE* foreign = std::fopen(fileOf("c").c_str(), "w");
+    if (foreign != nullptr) {
+      std::fputs("d\nforeign", foreign);
+      std::fclose(foreign);
+    }
+    CHECK(!cache.Lookup("c", out));
+    CHECK(CacheStat(cache, "entries") == 0 && CacheStat(cache, "bytes") == 0);
+  }
+
+  // The index persists across processes and opens
+  {
+    ResultCache cache;
+    CHECK(cache.Open(cacheDir, 1 << 20));
+    CHECK(CacheStat(cache, "misses") == 4);
+  }
+
+  // Three 102-byte entries under a 250-byte bound: touching "k1" makes
+  // "k2" the least recently used one
+  {
+    ResultCache cache;
+    CHECK(cache.Open(root + "/lru", 250));
+    std::string out;
+    CHECK(cache.Insert("k1", payload.substr(0, 99)));
+    CHECK(cache.Insert("k2", payload.substr(0, 99)));
+    CHECK(cache.Lookup("k1", out));
+    CHECK(cache.Insert("k3", payload.substr(0, 99)));
+    CHECK(CacheStat(cache, "entries") == 2 && CacheStat(cache, "evictions") == 1);
+    CHECK(cache.Lookup("k1", out) && cache.Lookup("k3", out));
+    CHECK(!cache.Lookup("k2", out));
+    CHECK(access(fileOf("k2").c_str(), F_OK) != 0);
+  }
+
+  // Counters that claim entries no slot holds leave eviction without a
+  // victim; the index is rebuilt from the slots and files instead
+  {
+    const std::string corruptDir = root + "/corrupt";
+    ResultCache cache;
+    CHECK(cache.Open(corruptDir, 250));
+    CHECK(cache.Insert("k1", payload.substr(0, 99)));
+    int fd = open((corruptDir + "/index").c_str(), O_RDWR);
+    uint32_t entries = 50;
+    uint64_t bytes = 1 << 20;
+    CHECK(fd >= 0);
+    CHECK(pwrite(fd, &entries, sizeof(entries), offsetof(ResultCache::Header, entries)) == sizeof(entries));
+    CHECK(pwrite(fd, &bytes, sizeof(bytes), offsetof(ResultCache::Header, bytes)) == sizeof(bytes));
+    close(fd);
+    CHECK(cache.Insert("k2", payload.substr(0, 99)));
+    CHECK(CacheStat(cache, "entries") == 1 && CacheStat(cache, "bytes") == 102);
+    std::string out;
+    CHECK(cache.Lookup("k2", out) && !cache.Lookup("k1", out));
+  }
+
+  std::string cleanup = "rm -rf '" + root + "'";
+  CHECK(std::system(cleanup.c_str()) == 0);
+}
+
+// The batch kernels (AVX2 where the CPU has it, scalar otherwise and for
+// the tail) agree with the libm reference within the documented 1e-9
+static void TestAnalytic() {
+  const size_t n = 1027;  // Not a multiple of four: exercises the tail
+  Lcg rng(7);
+  std::vector<double> frequency(n);
+  std::vector<double> bandwidth(n);
+  std::vector<double> txPower(n);
+  std::vector<uint8_t> tdd(n);
+  for (size_t i = 0; i < n; i++) {
+    frequency[i] = 0.6e9 + rng.Next() * 99.4e9;
+    bandwidth[i] = 5e6 + rng.Next() * 395e6;
+    txPower[i] = -500 + rng.Next() * 1000;  // snr within +/- 260 dB
+    tdd[i] = rng.Next() < 0.5;
+  }
+  frequency[0] = 6e9;  // Boundary of the MIMO layer switch
+  txPower[1] = 20;
+
+  std::vector<double> throughput(n);
+  std::vector<double> latency(n);
+  std::vector<double> scalarThroughput(n);
+  std::vector<double> scalarLatency(n);
+  AnalyticBatch batch;
+  batch.n = n;
+  batch.frequency = frequency.data();
+  batch.bandwidth = bandwidth.data();
+  batch.txPower = txPower.data();
+  batch.tdd = tdd.data();
+  batch.throughput = throughput.data();
+  batch.latency = latency.data();
+  AnalyticEvaluateBatch(batch);
+
+  AnalyticBatch scalar = batch;
+  scalar.throughput = scalarThroughput.data();
+  scalar.latency = scalarLatency.data();
+  AnalyticEvaluateBatchScalar(scalar, 0, n);
+
+  for (size_t i = 0; i < n; i++) {
+    double refThroughput;
+    double refLatency;
+    AnalyticEvaluate(frequency[i], bandwidth[i], tdd[i] != 0, txPower[i], refThroughput, refLatency);
+    // Far below 0 dB the spectral efficiency underflows towards 0 in both
+    CHECK_NEAR(throughput[i], refThroughput, 1e-9);
+    CHECK_NEAR(scalarThroughput[i], refThroughput, 1e-9);
+    CHECK(latency[i] == refLatency && scalarLatency[i] == refLatency);
+  }
+
+#ifdef NR_SIM_ANALYTIC_X86
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    std::vector<double> vectorThroughput(n, -1);
+    std::vector<double> vectorLatency(n, -1);
+    AnalyticBatch vector = batch;
+    vector.throughput = vectorThroughput.data();
+    vector.latency = vectorLatency.data();
+    size_t done = AnalyticEvaluateBatchAvx2(vector);
+    CHECK(done == n / 4 * 4);
+    for (size_t i = 0; i < done; i++) {
+      CHECK_NEAR(vectorThroughput[i], scalarThroughput[i], 1e-12);
+      CHECK(vectorLatency[i] == scalarLatency[i]);
+    }
+    CHECK(vectorThroughput[n - 1] == -1);
+  } else {
+    std::printf("analytic: no AVX2/FMA on this CPU, only the scalar kernel was tested\n");
+  }
+#endif
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<std::pair<std::string, std::function<void()>>> tests = {
+    {"sweep", TestSweep},
+    {"stats", TestStats},
+    {"flow-stats", TestFlowStats},
+    {"saturating-window", TestSaturatingWindow},
+    {"histogram", TestHistogram},
+    {"analytic", TestAnalytic},
+    {"result-cache", TestResultCache},
+  };
+  std::vector<std::string> selected(argv + 1, argv + argc);
+  for (const std::string& name : selected) {
+    if (std::none_of(tests.begin(), tests.end(), [&name](const auto& t) { return t.first == name; })) {
+      std::fprintf(stderr, "unknown test '%s'\n", name.c_str());
+      return 2;
+    }
+  }
+  for (const auto& test : tests) {
+    if (!selected.empty() && std::find(selected.begin(), selected.end(), test.first) == selected.end()) {
+      continue;
+    }
+    uint32_t before = gFailures;
+    test.second();
+    std::printf("%s: %s\n", test.first.c_str(), gFailures == before ? "ok" : "FAILED");
+  }
+  return std::min<uint32_t>(gFailures, 255);
+}
@@ -13,10 +13,56 @@
 #include "ns3/nr-module.h"
 #include "ns3/antenna-module.h"
 #include "ns3/buildings-module.h"
+#include "ns3/flow-monitor-module.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-module.h"
+#endif
+#include "nr-sim-analytic.h"
+#include "nr-sim-beam-cache.h"
+#include "nr-sim-channel-cache.h"
+#include "nr-sim-endpoint-probe.h"
+#include "nr-sim-event-profiler.h"
+#include "nr-sim-flow-collector.h"
+#include "nr-sim-hex-topology.h"
+#include "nr-sim-histogram.h"
+#include "nr-sim-json.h"
+#include "nr-sim-mpi.h"
+#include "nr-sim-profile.h"
+#include "nr-sim-result-cache.h"
+#include "nr-sim-saturating-source.h"
+#include "nr-sim-shm-result.h"
+#include "nr-sim-stats.h"
+#include "nr-sim-sweep.h"
+#include "nr-sim-timeseries.h"
+#include "nr-sim-trace-replay.h"
+#include "nr-sim-worker-pool.h"
+#include "nr-sim-wrap-around.h"
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <link.h>
+#include <new>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace ns3;
 NS_LOG_COMPONENT_DEFINE("NrSimulation");
@@ -27,65 +73,467 @@ double gBandwidth = 20e6;      // Default: 20 MHz
 std::string gDuplexMode = "TDD"; // Default: Time Division Duplex
 double gTxPower = 20.0;        // Default: 20 dBm
 std::string gOutputPath = "simulation_output.json"; // Default output path
+bool gProfile = false;         // Report per-phase wall time, memory and allocations
+bool gEventProfile = false;    // Run on ProfilingSimulatorImpl and report the hottest event types
+uint32_t gEventProfileTop = 20; // Event types listed in the event profile
+uint16_t gNumerology = 0;      // NR numerology mu (subcarrier spacing 15 kHz * 2^mu)
+uint32_t gSites = 0;           // Hexagonal multi-site layout (0 = single gNB/UE link)
+std::string gTraffic = "cbr";  // Downlink traffic: cbr (1500 B every 1 ms), saturating (full buffer) or trace
+std::string gTrafficTrace = ""; // NRTR packet arrival trace replayed with --traffic=trace
+uint32_t gSaturatingWindowKb = 64; // Bytes in flight per UE for saturating traffic, in KB
+uint32_t gSectorsPerSite = 3;  // Cells per site in the hexagonal layout
+uint32_t gUesPerCell = 10;     // UEs dropped per cell in the hexagonal layout
+double gIsd = 500.0;           // Inter-site distance in meters
+std::string gAnalyticBatch = ""; // CSV or NRAB grid evaluated with the closed-form model
+std::string gAnalyticOutput = ""; // Results of --analyticBatch (default: input path + ".out")
+std::string gCacheDir = "";    // Result cache directory (empty = no caching)
+uint32_t gCacheMaxMb = 256;    // Size bound of the result cache before LRU eviction
+std::string gChannelCacheDir = ""; // Directory of persisted 3GPP channel state (empty = regenerate)
+std::string gBeamforming = "default"; // Ideal beamforming method: default or cellScan
+std::string gBeamCacheDir = "";  // Directory of persisted cell-scan beam pairs (empty = default beamforming)
+double gBeamformingPeriod = 0.1; // Seconds between ideal beamforming updates
+std::string gJobId = "";       // Echoed back in the results when set
+std::string gShmName = "";     // POSIX shared memory object to publish results into (empty = JSON file)
+std::string gServeSocket = ""; // Unix socket path for --serve mode
+std::string gSweepSpec = "";   // Parameter grid for --sweep mode
+std::string gSweepMode = "cartesian"; // How --sweep lists combine: cartesian or list
+uint32_t gWorkers = 0;         // Max concurrent worker processes (0 = core count)
+double gWarmup = 0.1;          // Simulated seconds discarded before sampling starts
+double gWindow = 0.05;         // Length of each throughput/latency sampling window (s)
+double gTolerance = 0.02;      // Max relative change between successive windows to count as stable
+uint32_t gStableWindows = 3;   // Consecutive stable window pairs needed to stop early
+double gMaxSimTime = 2.0;      // Hard cap on simulated time (s)
+std::string gTimeSeriesPath = ""; // Optional columnar binary per-flow time series
+std::string gFlowProbe = "flowmonitor"; // Flow measurement: flowmonitor or endpoint
+uint32_t gProbeSampling = 1;   // Endpoint probe reads 1 in N received packets (1 = all)
+double gProgressInterval = 0.0; // Simulated seconds between NDJSON progress records on stdout (0 = off)
+uint32_t gReplications = 1;    // Max independent replications (distinct RngRun values)
+uint32_t gMinReplications = 3; // Replications to run before early stopping may kick in
+double gCiTarget = 0.0;        // Stop once the 95% CI half-width / mean drops below this (0 = never)
+std::string gMpi = "off";      // Distributed execution under mpirun: off, distributed or nullmessage
+double gMpiLookahead = 0.001;  // S1-U and X2 link delay with --mpi, the lookahead between ranks (s)
 
 // Global metrics collection
 double gThroughput = 0.0;
 double gLatency = 0.0;
 
-// Function to collect throughput statistics
-static void
-ThroughputMonitor (FlowMonitorHelper* fmhelper, Ptr<FlowMonitor> monitor)
-{
-  monitor->CheckForLostPackets ();
-  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
-
-  double totalThroughput = 0.0;
-  
-  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); ++i)
-    {
-      if (i->second.rxBytes > 0)
-        {
-          double throughput = i->second.rxBytes * 8.0 / (i->second.timeLastRxPacket.GetSeconds() - i->second.timeFirstTxPacket.GetSeconds()) / 1000;
-          totalThroughput += throughput;
-          
-          if (i->second.rxPackets > 0)
-            {
-              double latency = i->second.delaySum.GetSeconds() / i->second.rxPackets;
-              // Update global latency (average across all flows)
-              gLatency = (gLatency + latency) / 2.0;
+// Per-flow counters sampled from FlowMonitor without copying its map
+FlowStatsCollector gFlowStats;
+
+// Per-window, per-flow counters written when --timeSeriesPath is set
+TimeSeriesWriter gTimeSeries;
+
+// Last totals reported by ProgressProbe and the wall-clock start of Run()
+FlowTotals gProgressLast;
+std::chrono::steady_clock::time_point gRunStart;
+
+// One-way delay of every packet the UEs receive after the warm-up
+LatencyHistogram gLatencyHistogram;
+
+// Per-phase timings of RunSimulation() when --profile is set
+PhaseProfiler gProfiler;
+
+// Windowed sampling state for steady-state detection
+struct SteadyState {
+  bool warmedUp = false;
+  FlowTotals base;             // Totals at the end of the warm-up
+  FlowTotals last;             // Totals at the end of the previous window
+  double prevThroughput = 0.0;
+  double prevLatency = 0.0;
+  uint32_t windows = 0;
+  uint32_t stable = 0;
+  bool converged = false;
+};
+SteadyState gSteady;
+
+// Additional top-level JSON members (name, raw JSON value) written with the results
+std::vector<std::pair<std::string, std::string>> gResultSections;
+
+// Results of earlier runs keyed by their canonical inputs (--cacheDir)
+ResultCache gCache;
+
+// This process's MPI rank and the rank count (0 of 1 without --mpi)
+MpiPartition gPartition(0, 1);
+
+// Bring gFlowStats up to date. Without a monitor EndpointProbe already
+// writes the counters as packets arrive.
+static void SyncFlowStats(Ptr<FlowMonitor> monitor) {
+  if (monitor) {
+    gFlowStats.Sync(monitor->GetFlowStats());
+  }
+}
+
+static bool WithinTolerance(double current, double previous) {
+  return std::fabs(current - previous) <= gTolerance * std::max(std::fabs(previous), 1e-12);
+}
+
+// Self-rescheduling probe: the first call marks the end of the warm-up, each
+// later call closes one window and stops the run once enough successive
+// windows agree within gTolerance
+static void SteadyStateProbe(Ptr<FlowMonitor> monitor) {
+  SyncFlowStats(monitor);
+  const FlowTotals& totals = gFlowStats.GetTotals();
+
+  if (!gSteady.warmedUp) {
+    gSteady.warmedUp = true;
+    gSteady.base = totals;
+  } else {
+    FlowTotals window = totals - gSteady.last;
+    double throughput = window.rxBytes * 8.0 / gWindow;
+    double latency = window.GetMeanDelay();
+    bool stable = window.rxPackets > 0 && gSteady.windows > 0 &&
+                  WithinTolerance(throughput, gSteady.prevThroughput) &&
+                  WithinTolerance(latency, gSteady.prevLatency);
+    gSteady.stable = stable ? gSteady.stable + 1 : 0;
+    gSteady.prevThroughput = throughput;
+    gSteady.prevLatency = latency;
+    gSteady.windows++;
+    NS_LOG_INFO("Window " << gSteady.windows << " at " << Simulator::Now().GetSeconds() << " s: "
+                << throughput << " bps, " << latency << " s");
+    // Ranks only see their own cells, and stopping one rank alone would
+    // stall the others, so distributed runs always go to gMaxSimTime
+    if (gSteady.stable >= gStableWindows && !gPartition.IsDistributed()) {
+      gSteady.converged = true;
+      Simulator::Stop();
+      return;
+    }
+  }
+
+  gSteady.last = totals;
+  Simulator::Schedule(Seconds(gWindow), &SteadyStateProbe, monitor);
+}
+
+// Self-rescheduling probe appending every flow's cumulative counters to the
+// time series once per window, from the start of the run
+static void TimeSeriesProbe(Ptr<FlowMonitor> monitor) {
+  if (monitor) {
+    monitor->CheckForLostPackets();
+  }
+  SyncFlowStats(monitor);
+  int64_t now = Simulator::Now().GetNanoSeconds();
+  for (uint32_t i = 0; i < gFlowStats.GetNFlows(); i++) {
+    gTimeSeries.Append(now, i + 1, gFlowStats.GetRxBytes(i), gFlowStats.GetRxPackets(i),
+                       gFlowStats.GetDelaySumNs(i), gFlowStats.GetLostPackets(i));
+  }
+  Simulator::Schedule(Seconds(gWindow), &TimeSeriesProbe, monitor);
+}
+
+// Self-rescheduling probe printing one NDJSON progress record per interval
+// with the throughput and latency measured since the previous record
+static void ProgressProbe(Ptr<FlowMonitor> monitor) {
+  SyncFlowStats(monitor);
+  FlowTotals window = gFlowStats.GetTotals() - gProgressLast;
+  gProgressLast = gFlowStats.GetTotals();
+  double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - gRunStart).count();
+  std::cout << "{\"type\": \"progress\""
+            << ", \"simTime\": " << Simulator::Now().GetSeconds()
+            << ", \"wallTime\": " << wallTime
+            << ", \"events\": " << Simulator::GetEventCount()
+            << ", \"throughput\": " << window.rxBytes * 8.0 / gProgressInterval
+            << ", \"latency\": " << window.GetMeanDelay() << "}" << std::endl;
+  Simulator::Schedule(Seconds(gProgressInterval), &ProgressProbe, monitor);
+}
+
+// UdpServer Rx hook: the client's SeqTsHeader carries the send timestamp.
+// Only connected with FlowMonitor; EndpointProbe reports its sampled delays
+// through RecordProbeDelay instead of peeking every packet a second time.
+static void RecordRxDelay(Ptr<const Packet> packet, const Address& from, const Address& to) {
+  if (!gSteady.warmedUp) {
+    return;
+  }
+  SeqTsHeader seqTs;
+  if (packet->PeekHeader(seqTs) == seqTs.GetSerializedSize()) {
+    gLatencyHistogram.Record((Simulator::Now() - seqTs.GetTs()).GetSeconds());
+  }
+}
+
+static void RecordProbeDelay(int64_t delayNs) {
+  if (gSteady.warmedUp) {
+    gLatencyHistogram.Record(delayNs * 1e-9);
+  }
+}
+
+// Count every heap allocation for the --profile report; the array, nothrow
+// and sized forms all forward to these two. Without --profile this costs one
+// relaxed load and a predicted branch per allocation.
+void* operator new(std::size_t size) {
+  if (gCountAllocations.load(std::memory_order_relaxed)) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  if (void* p = std::malloc(size > 0 ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+// Function to write results as JSON, pretty-printed or as a single NDJSON line
+void WriteResultsJson(std::ostream& out, double throughput, double latency, bool pretty) {
+  const char* nl = pretty ? "\n" : "";
+  const char* in1 = pretty ? "  " : "";
+  const char* in2 = pretty ? "    " : "";
+  out << "{" << nl;
+  if (!gJobId.empty()) {
+    out << in1 << "\"jobId\": " << JsonQuote(gJobId) << "," << nl;
+  }
+  out << in1 << "\"frequency\": " << gFrequency << "," << nl;
+  out << in1 << "\"bandwidth\": " << gBandwidth << "," << nl;
+  out << in1 << "\"duplexMode\": \"" << gDuplexMode << "\"," << nl;
+  out << in1 << "\"transmitPower\": " << gTxPower << "," << nl;
+  out << in1 << "\"results\": {" << nl;
+  out << in2 << "\"throughput\": " << throughput << "," << nl;
+  out << in2 << "\"latency\": " << latency << nl;
+  out << in1 << "}";
+  for (const auto& section : gResultSections) {
+    out << "," << nl << in1 << "\"" << section.first << "\": " << section.second;
+  }
+  out << nl << "}" << nl;
+}
+
+// Function to write results to a JSON file, or to stdout as one NDJSON
+// line for "-". Files are written next to the target and renamed over it,
+// so concurrent readers only ever see a complete result.
+bool WriteResultsToJson(double throughput, double latency, const std::string& outputPath) {
+  if (outputPath == "-") {
+    WriteResultsJson(std::cout, throughput, latency, false);
+    std::cout.flush();
+    return static_cast<bool>(std::cout);
+  }
+  std::string temp = outputPath + ".tmp." + std::to_string(getpid());
+  std::ofstream outFile(temp);
+  WriteResultsJson(outFile, throughput, latency, true);
+  outFile.close();
+  if (!outFile || std::rename(temp.c_str(), outputPath.c_str()) != 0) {
+    NS_LOG_ERROR("Cannot write results to " << outputPath << ": " << std::strerror(errno));
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Publish the results into the shared memory object gShmName and announce
+// it on stdout. Fixed fields and the per-flow counters are stored binary;
+// jobId and the result sections travel as one JSON object.
+bool PublishSharedResult(double throughput, double latency) {
+  SharedResult::Header header = {};
+  header.flowCount = gFlowStats.GetNFlows();
+  header.throughput = throughput;
+  header.latency = latency;
+  header.frequency = gFrequency;
+  header.bandwidth = gBandwidth;
+  header.transmitPower = gTxPower;
+  header.tdd = gDuplexMode == "TDD" ? 1 : 0;
+
+  std::vector<double> values(uint64_t(SharedResult::kColumns) * header.flowCount);
+  std::vector<const double*> columns;
+  for (uint32_t c = 0; c < SharedResult::kColumns; c++) {
+    columns.push_back(values.data() + uint64_t(c) * header.flowCount);
+  }
+  for (uint32_t i = 0; i < header.flowCount; i++) {
+    values[i] = gFlowStats.GetRxBytes(i);
+    values[header.flowCount + i] = gFlowStats.GetRxPackets(i);
+    values[2 * header.flowCount + i] = gFlowStats.GetDelaySumNs(i);
+    values[3 * header.flowCount + i] = gFlowStats.GetLostPackets(i);
+  }
+
+  std::ostringstream json;
+  json << "{\"jobId\": " << JsonQuote(gJobId);
+  for (const auto& section : gResultSections) {
+    json << ", \"" << section.first << "\": " << section.second;
+  }
+  json << "}";
+
+  std::string error;
+  if (!SharedResult::Publish(gShmName, header, columns, json.str(), error)) {
+    NS_LOG_ERROR("Cannot publish results: " << error);
+    return false;
+  }
+  std::cout << "{\"type\": \"result\", \"shm\": " << JsonQuote(gShmName) << ", \"bytes\": "
+            << SharedResult::Size(header.flowCount, json.str().size()) << "}" << std::endl;
+  return true;
+}
+
+// Deliver the results of a single run or a replication set
+static bool WriteResults(double throughput, double latency) {
+  if (!gShmName.empty()) {
+    return PublishSharedResult(throughput, latency);
+  }
+  return WriteResultsToJson(throughput, latency, gOutputPath);
+}
+
+// GNU build id of the loaded object that contains symbol, in hex. The
+// linker derives it from the object's contents, so it changes exactly when
+// the code does. "" if the object has none.
+static std::string BuildId(const void* symbol) {
+  struct Search {
+    uintptr_t address;
+    std::string id;
+  } search = {reinterpret_cast<uintptr_t>(symbol), ""};
+  dl_iterate_phdr(
+    [](dl_phdr_info* info, size_t, void* data) {
+      Search& search = *static_cast<Search*>(data);
+      bool contains = false;
+      for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& segment = info->dlpi_phdr[i];
+        uintptr_t start = info->dlpi_addr + segment.p_vaddr;
+        if (segment.p_type == PT_LOAD && search.address >= start && search.address < start + segment.p_memsz) {
+          contains = true;
+        }
+      }
+      if (!contains) {
+        return 0;
+      }
+      for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& segment = info->dlpi_phdr[i];
+        if (segment.p_type != PT_NOTE) {
+          continue;
+        }
+        const char* p = reinterpret_cast<const char*>(info->dlpi_addr + segment.p_vaddr);
+        const char* end = p + segment.p_memsz;
+        while (p + sizeof(ElfW(Nhdr)) <= end) {
+          const ElfW(Nhdr)* note = reinterpret_cast<const ElfW(Nhdr)*>(p);
+          const char* name = p + sizeof(*note);
+          const unsigned char* desc = reinterpret_cast<const unsigned char*>(name + ((note->n_namesz + 3) & ~3u));
+          if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && std::memcmp(name, "GNU", 4) == 0) {
+            static const char digits[] = "0123456789abcdef";
+            for (uint32_t b = 0; b < note->n_descsz; b++) {
+              search.id += digits[desc[b] >> 4];
+              search.id += digits[desc[b] & 15];
             }
+            return 1;
+          }
+          p = reinterpret_cast<const char*>(desc) + ((note->n_descsz + 3) & ~3u);
         }
+      }
+      return 1;
+    },
+    &search);
+  return search.id;
+}
+
+// Identify the build that produced a cached result: this binary and the
+// ns-3 core and nr libraries, by build id, or by path, size and
+// modification time for an object linked without one
+static std::string BuildFingerprint() {
+  std::ostringstream out;
+  const void* symbols[] = {reinterpret_cast<const void*>(&BuildFingerprint),
+                           reinterpret_cast<const void*>(&Simulator::Run),
+                           reinterpret_cast<const void*>(&NrHelper::GetTypeId)};
+  std::vector<std::string> seen;
+  for (const void* symbol : symbols) {
+    std::string id = BuildId(symbol);
+    Dl_info info;
+    if (id.empty() && dladdr(symbol, &info) != 0 && info.dli_fname != nullptr) {
+      // The executable's own name may be relative to a directory since left
+      std::string file = symbol == symbols[0] ? "/proc/self/exe" : info.dli_fname;
+      struct stat st;
+      if (stat(file.c_str(), &st) == 0) {
+        id = file + ":" + std::to_string(st.st_size) + ":" + std::to_string(st.st_mtime);
+      }
     }
-  
-  // Update global throughput
-  gThroughput = totalThroughput * 1000; // convert to bps
+    // A static build holds all three in one object
+    if (!id.empty() && std::find(seen.begin(), seen.end(), id) == seen.end()) {
+      out << (seen.empty() ? "" : " ") << id;
+      seen.push_back(id);
+    }
+  }
+  return out.str();
 }
 
-// Function to write results to a JSON file
-void WriteResultsToJson(double throughput, double latency, const std::string& outputPath) {
-  std::ofstream outFile(outputPath);
-  outFile << "{\n";
-  outFile << "  \"frequency\": " << gFrequency << ",\n";
-  outFile << "  \"bandwidth\": " << gBandwidth << ",\n";
-  outFile << "  \"duplexMode\": \"" << gDuplexMode << "\",\n";
-  outFile << "  \"transmitPower\": " << gTxPower << ",\n";
-  outFile << "  \"results\": {\n";
-  outFile << "    \"throughput\": " << throughput << ",\n";
-  outFile << "    \"latency\": " << latency << "\n";
-  outFile << "  }\n";
-  outFile << "}\n";
-  outFile.close();
+// Canonical description of everything that determines a run's results
+static std::string CacheKey() {
+  static const std::string fingerprint = BuildFingerprint();
+  UintegerValue seed;
+  UintegerValue run;
+  GlobalValue::GetValueByName("RngSeed", seed);
+  GlobalValue::GetValueByName("RngRun", run);
+  std::ostringstream key;
+  key.precision(17);
+  key << "nr-simulation v3 [" << fingerprint << "] frequency=" << gFrequency
+      << " bandwidth=" << gBandwidth << " duplexMode=" << gDuplexMode << " transmitPower=" << gTxPower
+      << " numerology=" << gNumerology << " traffic=" << gTraffic
+      << " beamforming=" << (gBeamCacheDir.empty() ? gBeamforming : "cachedCellScan")
+      << " beamformingPeriod=" << gBeamformingPeriod
+      << " channelModel=" << (gChannelCacheDir.empty() ? "ThreeGpp" : "PersistentThreeGpp");
+  if (gTraffic == "saturating") {
+    key << " saturatingWindowKb=" << gSaturatingWindowKb;
+  }
+  if (gTraffic == "trace") {
+    struct stat st;
+    key << " trafficTrace=" << gTrafficTrace;
+    if (stat(gTrafficTrace.c_str(), &st) == 0) {
+      key << ":" << st.st_size << ":" << st.st_mtime;
+    }
+  }
+  key << " sites=" << gSites << " sectorsPerSite=" << gSectorsPerSite
+      << " uesPerCell=" << gUesPerCell << " isd=" << gIsd << " warmup=" << gWarmup
+      << " window=" << gWindow << " tolerance=" << gTolerance << " stableWindows=" << gStableWindows
+      << " maxSimTime=" << gMaxSimTime << " flowProbe=" << gFlowProbe << " probeSampling=" << gProbeSampling << " seed=" << seed.Get() << " run=" << run.Get();
+  return key.str();
 }
 
-int main(int argc, char *argv[]) {
-  // Command line arguments
-  CommandLine cmd(__FILE__);
-  cmd.AddValue("frequency", "Carrier frequency in Hz", gFrequency);
-  cmd.AddValue("bandwidth", "System bandwidth in Hz", gBandwidth);
-  cmd.AddValue("duplexMode", "Duplex mode (TDD or FDD)", gDuplexMode);
-  cmd.AddValue("transmitPower", "Transmission power in dBm", gTxPower);
-  cmd.AddValue("outputPath", "Path for output JSON file", gOutputPath);
-  cmd.Parse(argc, argv);
+// Canonical description of everything that determines the channel state:
+// the deployment, carrier, scenario, antenna arrays and seed, but not the
+// power, bandwidth or duplex settings a sweep varies on top of it
+static std::string ChannelCacheKey() {
+  static const std::string fingerprint = BuildFingerprint();
+  UintegerValue seed;
+  UintegerValue run;
+  GlobalValue::GetValueByName("RngSeed", seed);
+  GlobalValue::GetValueByName("RngRun", run);
+  std::ostringstream key;
+  key.precision(17);
+  key << "nr-channel v2 [" << fingerprint << "] frequency=" << gFrequency << " scenario=UMa"
+      << " sites=" << gSites << " sectorsPerSite=" << gSectorsPerSite << " uesPerCell=" << gUesPerCell
+      << " isd=" << gIsd << " gnbArray=4x4 ueArray=2x2 seed=" << seed.Get() << " run=" << run.Get();
+  return key.str();
+}
+
+// Cached results are the metrics line followed by one "name<TAB>json" line
+// per result section
+static std::string SerializeResult() {
+  std::ostringstream out;
+  out.precision(17);
+  out << gThroughput << " " << gLatency << "\n";
+  for (const auto& section : gResultSections) {
+    out << section.first << "\t" << section.second << "\n";
+  }
+  return out.str();
+}
+
+static bool RestoreResult(const std::string& payload) {
+  std::istringstream in(payload);
+  std::string line;
+  if (!(in >> gThroughput >> gLatency) || !std::getline(in, line)) {
+    return false;
+  }
+  gResultSections.clear();
+  while (std::getline(in, line)) {
+    std::string::size_type tab = line.find('\t');
+    if (tab != std::string::npos) {
+      gResultSections.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+    }
+  }
+  return true;
+}
+
+// Profiling and time-series runs exist for their side outputs, so they
+// always simulate
+static bool CacheEnabled() {
+  return !gCacheDir.empty() && !gProfile && !gEventProfile && gTimeSeriesPath.empty() &&
+         !gPartition.IsDistributed();
+}
+
+// Build the scenario for the current parameters, run it and fill in
+// gThroughput/gLatency. Safe to call once per process; --serve forks a
+// fresh child for every job so each one gets a pristine Simulator.
+void RunSimulation() {
+  gThroughput = 0.0;
+  gLatency = 0.0;
 
   // Log simulation parameters
   NS_LOG_INFO("NR simulation with parameters:");
@@ -94,17 +542,89 @@ int main(int argc, char *argv[]) {
   NS_LOG_INFO("Duplex Mode: " << gDuplexMode);
   NS_LOG_INFO("Tx Power: " << gTxPower << " dBm");
   
-  // Enable logging components
-  LogComponentEnable("NrSimulation", LOG_LEVEL_INFO);
+  // Answer repeated parameter sets from the cache before building anything.
+  // Opened per run so that forked workers each hold their own flock().
+  std::string cacheKey;
+  if (CacheEnabled() && gCache.Open(gCacheDir, uint64_t(gCacheMaxMb) << 20)) {
+    auto lookupStart = std::chrono::steady_clock::now();
+    cacheKey = CacheKey();
+    std::string payload;
+    if (gCache.Lookup(cacheKey, payload) && RestoreResult(payload)) {
+      double lookupTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - lookupStart).count();
+      gResultSections.emplace_back("cache", "{\"hit\": true, \"lookupTime\": " + std::to_string(lookupTime) +
+                                            ", \"stats\": " + gCache.StatsToJson() + "}");
+      NS_LOG_INFO("Result cache hit in " << lookupTime << " s");
+      gCache.Close();
+      return;
+    }
+  } else if (CacheEnabled()) {
+    NS_LOG_WARN("Cannot open result cache " << gCacheDir);
+  }
   
-  // Set simulation time
-  double simTime = 2.0; // seconds
+  gSteady = SteadyState();
+  gFlowStats = FlowStatsCollector();
+  gLatencyHistogram = LatencyHistogram();
+  gProgressLast = FlowTotals();
   
-  // Create gNB and UE nodes
+  auto setupStart = std::chrono::steady_clock::now();
+  gProfiler.Mark("nodes");
+  
+  // Complete-ring layouts wrap around: every UE-gNB link uses the UE's
+  // copy nearest to the gNB among the cluster and its six tiled copies
+  HexTopology hex(std::max<uint32_t>(gSites, 1), gSectorsPerSite, gIsd);
+  bool wrapAround = gSites > 0 && hex.IsFullRings();
+  if (gSites > 0 && !wrapAround) {
+    NS_LOG_WARN("--sites=" << gSites << " is not a complete set of rings (1, 7, 19, 37, ...); "
+                "running without wrap-around, so edge cells see less interference");
+  }
+  WrapAroundMobilityModel::SetShifts(wrapAround ? hex.GetWrapAroundShifts() : std::vector<Vector>());
+  
+  // Serve channel matrices of a static deployment from an earlier run.
+  // Must be set before the helpers create their channel models.
+  if (!gChannelCacheDir.empty()) {
+    PersistentThreeGppChannelModel::Configure(gChannelCacheDir, ChannelCacheKey());
+    Config::SetDefault("ns3::ThreeGppSpectrumPropagationLossModel::ChannelModel",
+                       StringValue("ns3::PersistentThreeGppChannelModel"));
+  } else if (wrapAround) {
+    Config::SetDefault("ns3::ThreeGppSpectrumPropagationLossModel::ChannelModel",
+                       StringValue("ns3::WrapAroundThreeGppChannelModel"));
+  }
+  
+  // Create gNB and UE nodes: the single gNB/UE link by default, or a
+  // hexagonal grid of sites x sectors cells with uesPerCell UEs each. With
+  // --mpi each cell and the UEs it serves get the system id of the rank
+  // owning the cell's site.
   NodeContainer gnbNodes;
   NodeContainer ueNodes;
-  gnbNodes.Create(1);
-  ueNodes.Create(1);
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
+  std::vector<uint32_t> servingCell; // Index of the gNB serving each UE
+  if (gSites == 0) {
+    gnbNodes.Create(1);
+    ueNodes.Create(1);
+    positionAlloc->Add(Vector(0.0, 0.0, 15.0));  // gNB coordinates
+    positionAlloc->Add(Vector(50.0, 0.0, 1.5));  // UE coordinates
+    servingCell.push_back(0);
+  } else {
+    std::vector<uint32_t> cellRank(hex.GetNCells());
+    for (uint32_t cell = 0; cell < hex.GetNCells(); cell++) {
+      cellRank[cell] = gPartition.GetSiteRank(hex.GetSite(cell), hex.GetNSites());
+      gnbNodes.Create(1, cellRank[cell]);
+      positionAlloc->Add(hex.GetSitePosition(hex.GetSite(cell), 25.0));  // UMa BS height
+    }
+    // Seeded by the global seed/run, so drops are reproducible per RngRun
+    Ptr<UniformRandomVariable> dropRng = CreateObject<UniformRandomVariable>();
+    dropRng->SetStream(1000);
+    servingCell.reserve(hex.GetNCells() * gUesPerCell);
+    for (uint32_t cell = 0; cell < hex.GetNCells(); cell++) {
+      for (uint32_t k = 0; k < gUesPerCell; k++) {
+        Vector position = hex.DropUe(cell, 35.0, 1.5, dropRng);  // 3GPP min 2D distance
+        positionAlloc->Add(position);
+        servingCell.push_back(hex.GetServingCell(position));
+        ueNodes.Create(1, cellRank[servingCell.back()]);
+      }
+    }
+  }
+  gFlowStats.Reserve(ueNodes.GetN());
   
   // Create device containers
   NetDeviceContainer gnbNetDev;
@@ -114,15 +634,15 @@ int main(int argc, char *argv[]) {
   MobilityHelper mobility;
   mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
   
-  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
-  positionAlloc->Add(Vector(0.0, 0.0, 15.0));  // gNB coordinates
-  positionAlloc->Add(Vector(50.0, 0.0, 1.5));  // UE coordinates
-  
   mobility.SetPositionAllocator(positionAlloc);
   mobility.Install(gnbNodes);
+  if (wrapAround) {
+    mobility.SetMobilityModel("ns3::WrapAroundMobilityModel");
+  }
   mobility.Install(ueNodes);
   
   // NR Settings
+  gProfiler.Mark("nrConfig");
   Ptr<NrHelper> nrHelper = CreateObject<NrHelper>();
   
   // Spectrum settings
@@ -131,9 +651,23 @@ int main(int argc, char *argv[]) {
   
   Ptr<NrPointToPointEpcHelper> epcHelper = CreateObject<NrPointToPointEpcHelper>();
   Ptr<IdealBeamformingHelper> beamformingHelper = CreateObject<IdealBeamformingHelper>();
+  beamformingHelper->SetAttribute("BeamformingPeriodicity", TimeValue(Seconds(gBeamformingPeriod)));
+  // Search each link's beam pair once, then rebuild it from the stored ids
+  // on every update and in later runs while the endpoints stay put
+  if (!gBeamCacheDir.empty()) {
+    CachedCellScanBeamforming::Configure(gBeamCacheDir, "nr-beams v1 " + ChannelCacheKey());
+    beamformingHelper->SetAttribute("BeamformingMethod", TypeIdValue(CachedCellScanBeamforming::GetTypeId()));
+  } else if (gBeamforming == "cellScan") {
+    beamformingHelper->SetAttribute("BeamformingMethod", TypeIdValue(CellScanBeamforming::GetTypeId()));
+  }
   
   nrHelper->SetBeamformingHelper(beamformingHelper);
   nrHelper->SetEpcHelper(epcHelper);
+  // The EPC core stays on rank 0; S1-U and X2 are the links between ranks
+  if (gPartition.IsDistributed()) {
+    epcHelper->SetAttribute("S1uLinkDelay", TimeValue(Seconds(gMpiLookahead)));
+    epcHelper->SetAttribute("X2LinkDelay", TimeValue(Seconds(gMpiLookahead)));
+  }
   
   // Configure gNB and UE devices
   nrHelper->InitializeOperationBand(&gnbNetDev, &ueNetDev);
@@ -149,15 +683,43 @@ int main(int argc, char *argv[]) {
   nrHelper->SetUeAntennaAttribute("AntennaElement", 
                                  PointerValue(CreateObject<ThreeGppAntennaModel>()));
   
+  nrHelper->SetGnbPhyAttribute("Numerology", UintegerValue(gNumerology));
+  
   // Set the transmission power
   nrHelper->SetGnbTxPower(gTxPower);
   nrHelper->SetUeTxPower(23.0);
   
-  // Install the actual devices
-  gnbNetDev = nrHelper->InstallGnbDevice(gnbNodes);
+  // Install the actual devices; gNBs in one call per sector bearing
+  gProfiler.Mark("installDevices");
+  if (gSites == 0) {
+    gnbNetDev = nrHelper->InstallGnbDevice(gnbNodes);
+  } else {
+    for (uint32_t sector = 0; sector < gSectorsPerSite; sector++) {
+      NodeContainer sectorNodes;
+      for (uint32_t site = 0; site < hex.GetNSites(); site++) {
+        sectorNodes.Add(gnbNodes.Get(sector * hex.GetNSites() + site));
+      }
+      nrHelper->SetGnbAntennaAttribute("BearingAngle", DoubleValue(hex.GetBearing(sector)));
+      gnbNetDev.Add(nrHelper->InstallGnbDevice(sectorNodes));
+    }
+  }
   ueNetDev = nrHelper->InstallUeDevice(ueNodes);
   
+  // Mirror pathloss and the LOS condition on every band's channel
+  uint32_t wrappedChannels = 0;
+  if (wrapAround) {
+    for (uint32_t cell = 0; cell < gnbNetDev.GetN(); cell++) {
+      Ptr<NrGnbNetDevice> gnb = DynamicCast<NrGnbNetDevice>(gnbNetDev.Get(cell));
+      for (uint32_t bwp = 0; bwp < gnb->GetCcMapSize(); bwp++) {
+        if (WrapAroundPropagationLossModel::Install(gnb->GetPhy(bwp)->GetSpectrumPhy()->GetSpectrumChannel())) {
+          wrappedChannels++;
+        }
+      }
+    }
+  }
+  
   // Internet stack
+  gProfiler.Mark("internet");
   InternetStackHelper internet;
   internet.Install(ueNodes);
   
@@ -166,57 +728,244 @@ int main(int argc, char *argv[]) {
   ipv4h.SetBase("1.0.0.0", "255.0.0.0");
   Ipv4InterfaceContainer ueIpIface = ipv4h.Assign(ueNetDev);
   
-  // Initialize routing
+  // Initialize routing and attach every UE to its serving cell
   Ipv4StaticRoutingHelper ipv4RoutingHelper;
-  Ptr<Ipv4StaticRouting> ueStaticRouting = ipv4RoutingHelper.GetStaticRouting(ueNodes.Get(0)->GetObject<Ipv4>());
-  ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
+  for (uint32_t u = 0; u < ueNodes.GetN(); u++) {
+    Ptr<Ipv4StaticRouting> ueStaticRouting = ipv4RoutingHelper.GetStaticRouting(ueNodes.Get(u)->GetObject<Ipv4>());
+    ueStaticRouting->SetDefaultRoute(epcHelper->GetUeDefaultGatewayAddress(), 1);
+    nrHelper->AttachToGnb(ueNetDev.Get(u), gnbNetDev.Get(servingCell[u]));
+  }
   
   // Create UDP application for traffic
+  gProfiler.Mark("applications");
   uint16_t dlPort = 1000;
   ApplicationContainer clientApps;
   ApplicationContainer serverApps;
   
-  // Install UDP server on UE
+  // Traffic and measurements only run for this rank's UEs (all of them
+  // without --mpi); app i belongs to UE localUes[i]
+  std::vector<uint32_t> localUes;
+  NodeContainer localUeNodes;
+  NodeContainer localNodes;
+  for (uint32_t u = 0; u < ueNodes.GetN(); u++) {
+    if (ueNodes.Get(u)->GetSystemId() == gPartition.GetRank()) {
+      localUes.push_back(u);
+      localUeNodes.Add(ueNodes.Get(u));
+    }
+  }
+  for (uint32_t cell = 0; cell < gnbNodes.GetN(); cell++) {
+    if (gnbNodes.Get(cell)->GetSystemId() == gPartition.GetRank()) {
+      localNodes.Add(gnbNodes.Get(cell));
+    }
+  }
+  localNodes.Add(localUeNodes);
+  
+  // Install UDP server on every UE
   UdpServerHelper dlServer(dlPort);
-  serverApps.Add(dlServer.Install(ueNodes.Get(0)));
+  serverApps.Add(dlServer.Install(localUeNodes));
+  if (gFlowProbe != "endpoint") {
+    for (uint32_t i = 0; i < serverApps.GetN(); i++) {
+      serverApps.Get(i)->TraceConnectWithoutContext("RxWithAddresses", MakeCallback(&RecordRxDelay));
+    }
+  }
   
-  // Install UDP client on remote host
+  // Install one downlink source per UE on its serving gNB: a constant-rate
+  // UDP client, a full-buffer source driven by its UE's deliveries, or a
+  // sender fed from the packet arrival trace
+  TraceReplay traceReplay;
+  std::vector<Ptr<TraceReplaySource>> traceSources(ueNodes.GetN());
+  std::string traffic = gTraffic;
+  if (traffic == "trace") {
+    std::string error;
+    if (!traceReplay.Open(gTrafficTrace, error)) {
+      NS_LOG_WARN("Cannot replay traffic trace (" << error << "), using cbr traffic");
+      traffic = "cbr";
+    }
+  }
   UdpClientHelper dlClient(ueIpIface.GetAddress(0), dlPort);
   dlClient.SetAttribute("MaxPackets", UintegerValue(1000000));
   dlClient.SetAttribute("Interval", TimeValue(MilliSeconds(1.0)));
   dlClient.SetAttribute("PacketSize", UintegerValue(1500));
   
-  clientApps.Add(dlClient.Install(gnbNodes.Get(0)));
+  for (uint32_t i = 0; i < localUes.size(); i++) {
+    uint32_t u = localUes[i];
+    if (traffic == "saturating") {
+      Ptr<SaturatingSource> source = CreateObject<SaturatingSource>();
+      source->SetAttribute("RemoteAddress", AddressValue(ueIpIface.GetAddress(u)));
+      source->SetAttribute("RemotePort", UintegerValue(dlPort));
+      source->SetAttribute("Window", UintegerValue(gSaturatingWindowKb * 1024));
+      gnbNodes.Get(servingCell[u])->AddApplication(source);
+      serverApps.Get(i)->TraceConnectWithoutContext("Rx", MakeCallback(&SaturatingSource::NotifyDelivered, source));
+      clientApps.Add(source);
+    } else if (traffic == "trace") {
+      Ptr<TraceReplaySource> source = CreateObject<TraceReplaySource>();
+      source->SetAttribute("RemoteAddress", AddressValue(ueIpIface.GetAddress(u)));
+      source->SetAttribute("RemotePort", UintegerValue(dlPort));
+      gnbNodes.Get(servingCell[u])->AddApplication(source);
+      traceSources[u] = source;
+      clientApps.Add(source);
+    } else {
+      dlClient.SetAttribute("RemoteAddress", AddressValue(ueIpIface.GetAddress(u)));
+      clientApps.Add(dlClient.Install(gnbNodes.Get(servingCell[u])));
+    }
+  }
   
-  // Start applications
-  serverApps.Start(MilliSeconds(500));
-  clientApps.Start(MilliSeconds(500));
+  // Start applications right away; the warm-up below absorbs the transient
+  serverApps.Start(Seconds(0));
+  clientApps.Start(Seconds(0));
+  if (traceReplay.IsOpen()) {
+    traceReplay.Start(traceSources);
+  }
   
-  // Monitor throughput
+  // Monitor throughput: FlowMonitor on every node, or counters taken only
+  // at each UE's source and sink
+  gProfiler.Mark("flowMonitor");
   FlowMonitorHelper flowHelper;
-  Ptr<FlowMonitor> monitor = flowHelper.InstallAll();
+  Ptr<FlowMonitor> monitor;
+  EndpointProbe endpointProbe(gFlowStats, gProbeSampling);
+  if (gFlowProbe == "endpoint") {
+    endpointProbe.SetDelayCallback(MakeCallback(&RecordProbeDelay));
+    for (uint32_t i = 0; i < localUes.size(); i++) {
+      endpointProbe.Install(clientApps.Get(i), serverApps.Get(i));
+    }
+  } else if (gPartition.IsDistributed()) {
+    monitor = flowHelper.Install(localNodes);
+  } else {
+    monitor = flowHelper.InstallAll();
+  }
+  
+  // Sample in windows after the warm-up until the metrics settle
+  Simulator::Schedule(Seconds(gWarmup), &SteadyStateProbe, monitor);
+  if (!gTimeSeriesPath.empty()) {
+    std::string timeSeriesPath = gTimeSeriesPath;
+    if (gPartition.GetRank() > 0) {
+      timeSeriesPath += "." + std::to_string(gPartition.GetRank());
+    }
+    if (gTimeSeries.Open(timeSeriesPath)) {
+      Simulator::Schedule(Seconds(gWindow), &TimeSeriesProbe, monitor);
+    } else {
+      NS_LOG_WARN("Cannot open time series file " << timeSeriesPath);
+    }
+  }
+  
+  if (gProgressInterval > 0 && gPartition.GetRank() == 0) {
+    Simulator::Schedule(Seconds(gProgressInterval), &ProgressProbe, monitor);
+  }
   
-  // Schedule throughput calculation
-  Simulator::Schedule (Seconds(1), &ThroughputMonitor, &flowHelper, monitor);
+  double setupTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  std::ostringstream topology;
+  topology << "{\"sites\": " << (gSites == 0 ? 1 : hex.GetNSites())
+           << ", \"cells\": " << gnbNodes.GetN() << ", \"ues\": " << ueNodes.GetN()
+           << ", \"isd\": " << (gSites == 0 ? 0.0 : gIsd)
+           << ", \"wrapAround\": " << (wrapAround ? "true" : "false")
+           << ", \"setupTime\": " << setupTime << ", \"setupPeakRssKb\": " << usage.ru_maxrss << "}";
+  gResultSections.emplace_back("topology", topology.str());
+  NS_LOG_INFO("Built " << gnbNodes.GetN() << " cells / " << ueNodes.GetN() << " UEs in " << setupTime << " s");
+  if (wrapAround && (wrappedChannels == 0 || WrapAroundThreeGppChannelModel::GetInstanceCount() == 0)) {
+    NS_LOG_WARN("Wrap-around is only partly applied: " << wrappedChannels << " pathloss chains and "
+                << WrapAroundThreeGppChannelModel::GetInstanceCount() << " channel models wrapped");
+  }
+  if (PersistentThreeGppChannelModel::IsConfigured() && PersistentThreeGppChannelModel::GetInstanceCount() == 0) {
+    NS_LOG_WARN("--channelCacheDir is set but no PersistentThreeGppChannelModel was created; channels are not cached");
+  }
   
-  // Run simulation
-  Simulator::Stop(Seconds(simTime));
+  // Run simulation, capped at gMaxSimTime if it never converges
+  gProfiler.Mark("run");
+  Simulator::Stop(Seconds(gMaxSimTime));
+  gRunStart = std::chrono::steady_clock::now();
   Simulator::Run();
+  double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - gRunStart).count();
+  double simTime = Simulator::Now().GetSeconds();
   
-  // Calculate final metrics
-  ThroughputMonitor(&flowHelper, monitor);
+  // Calculate final metrics over everything received after the warm-up,
+  gProfiler.Mark("results");
+  // falling back to the whole run if the warm-up never ended
+  if (monitor) {
+    monitor->CheckForLostPackets();
+  } else {
+    endpointProbe.Finish();
+  }
+  SyncFlowStats(monitor);
+  if (gTimeSeries.IsOpen()) {
+    gTimeSeries.Close();
+  }
+  FlowTotals totals = gFlowStats.GetTotals();
+  FlowTotals base = gSteady.base;
+  uint64_t events = Simulator::GetEventCount();
+  std::string mpiSection;
+#ifdef NS3_MPI
+  // Collect every rank's flows on rank 0
+  if (gPartition.IsDistributed()) {
+    gPartition.ReduceTotals(totals);
+    gPartition.ReduceTotals(base);
+    gPartition.MergeHistogram(gLatencyHistogram);
+    gPartition.ReduceSum(events);
+    gPartition.ReduceSum(traceReplay.GetStats().replayed);
+    gPartition.ReduceSum(traceReplay.GetStats().bytes);
+    std::ostringstream local;
+    local << "{\"cells\": " << (localNodes.GetN() - localUeNodes.GetN()) << ", \"ues\": " << localUes.size()
+          << ", \"events\": " << Simulator::GetEventCount() << ", \"wallTime\": " << wallTime << "}";
+    std::vector<std::string> ranks = gPartition.Gather(local.str());
+    std::ostringstream mpi;
+    mpi << "{\"simulator\": \"" << gMpi << "\", \"ranks\": " << gPartition.GetRanks()
+        << ", \"lookahead\": " << gMpiLookahead << ", \"perRank\": [";
+    for (uint32_t r = 0; r < ranks.size(); r++) {
+      mpi << (r > 0 ? ", " : "") << ranks[r];
+    }
+    mpi << "]}";
+    mpiSection = mpi.str();
+  }
+#endif
+  FlowTotals measured = totals - base;
+  if (gSteady.warmedUp && simTime > gWarmup && measured.rxPackets > 0) {
+    gThroughput = measured.rxBytes * 8.0 / (simTime - gWarmup);
+    gLatency = measured.GetMeanDelay();
+  } else if (gPartition.IsDistributed()) {
+    gThroughput = simTime > 0 ? totals.rxBytes * 8.0 / simTime : 0.0;
+    gLatency = totals.GetMeanDelay();
+  } else {
+    gThroughput = gFlowStats.GetActiveThroughput();
+    gLatency = totals.GetMeanDelay();
+  }
+  
+  std::ostringstream timeline;
+  timeline << "{\"warmup\": " << gWarmup << ", \"window\": " << gWindow
+           << ", \"windows\": " << gSteady.windows
+           << ", \"converged\": " << (gSteady.converged ? "true" : "false")
+           << ", \"simTime\": " << simTime << ", \"wallTime\": " << wallTime
+           << ", \"events\": " << events
+           << ", \"flowProbe\": \"" << gFlowProbe << "\"";
+  if (!monitor) {
+    timeline << ", \"probeSampling\": " << endpointProbe.GetSamplingPeriod()
+             << ", \"sampledPackets\": " << endpointProbe.GetSampledPackets();
+  }
+  timeline << "}";
+  gResultSections.emplace_back("timeline", timeline.str());
+  if (!mpiSection.empty()) {
+    gResultSections.emplace_back("mpi", mpiSection);
+  }
+  Ptr<ProfilingSimulatorImpl> eventProfiler = DynamicCast<ProfilingSimulatorImpl>(Simulator::GetImplementation());
+  if (eventProfiler) {
+    for (const std::string& line : eventProfiler->ToTable(gEventProfileTop)) {
+      NS_LOG_INFO(line);
+    }
+    gResultSections.emplace_back("eventProfile", eventProfiler->ToJson(gEventProfileTop));
+  }
+  if (traceReplay.IsOpen()) {
+    gResultSections.emplace_back("trafficTrace", traceReplay.StatsToJson());
+    traceReplay.Close();
+  }
+  if (gLatencyHistogram.GetCount() > 0) {
+    gResultSections.emplace_back("latencyPercentiles", gLatencyHistogram.PercentilesToJson());
+    gResultSections.emplace_back("latencySketch", gLatencyHistogram.ToJson());
+  }
   
   // If no valid throughput calculated, provide a fallback calculation
   if (gThroughput <= 0) {
     // Calculate simulated results using a simplified theoretical model
-    double snr = 10 + (gTxPower - 20) / 2; // Base 10dB SNR, adjusted for power
-    double spectralEfficiency = log2(1 + pow(10, snr/10));
-    double duplexEfficiency = (gDuplexMode == "TDD") ? 0.8 : 0.95;
-    double mimoFactor = (gFrequency < 6e9) ? 4 : 8;
-    double overheadFactor = 0.85;
-    
-    gThroughput = gBandwidth * spectralEfficiency * duplexEfficiency * mimoFactor * overheadFactor;
-    gLatency = 0.001 + (gDuplexMode == "TDD" ? 0.0005 : 0) + (100e6/gBandwidth)*0.0005;
+    AnalyticEvaluate(gFrequency, gBandwidth, gDuplexMode == "TDD", gTxPower, gThroughput, gLatency);
   }
   
   // Output the results
@@ -224,9 +973,708 @@ int main(int argc, char *argv[]) {
   NS_LOG_INFO("Throughput: " << gThroughput << " bps");
   NS_LOG_INFO("Latency: " << gLatency << " seconds");
   
-  // Write results to JSON file
-  WriteResultsToJson(gThroughput, gLatency, gOutputPath);
+  // Ranks hold overlapping channels and beams; only rank 0 writes them back
+  if (PersistentThreeGppChannelModel::IsConfigured() && gPartition.GetRank() == 0) {
+    if (!PersistentThreeGppChannelModel::Save()) {
+      NS_LOG_WARN("Cannot write channel cache in " << gChannelCacheDir);
+    }
+    gResultSections.emplace_back("channelCache", PersistentThreeGppChannelModel::StatsToJson());
+  }
+  if (CachedCellScanBeamforming::IsConfigured() && gPartition.GetRank() == 0) {
+    if (!CachedCellScanBeamforming::Save()) {
+      NS_LOG_WARN("Cannot write beam cache in " << gBeamCacheDir);
+    }
+    gResultSections.emplace_back("beamCache", CachedCellScanBeamforming::StatsToJson());
+  }
   
+  gProfiler.Mark("destroy");
   Simulator::Destroy();
+  gProfiler.Finish();
+  if (gProfiler.IsEnabled()) {
+    gResultSections.emplace_back("profile", gProfiler.ToJson());
+  }
+  if (!cacheKey.empty()) {
+    gCache.Insert(cacheKey, SerializeResult());
+    gResultSections.emplace_back("cache", "{\"hit\": false, \"stats\": " + gCache.StatsToJson() + "}");
+    gCache.Close();
+  }
+}
+
+// Touch every registered TypeId and its attribute table once in the server
+// process so forked children inherit warm pages instead of faulting them in
+static void WarmUpTypeIds() {
+  uint32_t attributes = 0;
+  for (uint16_t i = 0; i < TypeId::GetRegisteredN(); i++) {
+    attributes += TypeId::GetRegistered(i).GetAttributeN();
+  }
+  NS_LOG_INFO("Pre-warmed " << TypeId::GetRegisteredN() << " TypeIds (" << attributes << " attributes)");
+}
+
+// Write all of data to a pipe, retrying on short writes
+static bool WriteAll(int fd, const std::string& data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = write(fd, data.data() + done, data.size() - done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+// Apply one job line to the parameter globals; returns an error message or ""
+static std::string ParseJob(const std::string& line) {
+  if (line.find('{') == std::string::npos) {
+    return "job is not a JSON object";
+  }
+  JsonGetString(line, "jobId", gJobId);
+  JsonGetNumber(line, "frequency", gFrequency);
+  JsonGetNumber(line, "bandwidth", gBandwidth);
+  JsonGetString(line, "duplexMode", gDuplexMode);
+  JsonGetNumber(line, "transmitPower", gTxPower);
+  if (gDuplexMode != "TDD" && gDuplexMode != "FDD") {
+    return "duplexMode must be TDD or FDD";
+  }
+  if (gFrequency <= 0 || gBandwidth <= 0) {
+    return "frequency and bandwidth must be positive";
+  }
+  return "";
+}
+
+// Run one job in a forked child that writes its reply line to a pipe and
+// exits. Only the server writes to connections, so replies of concurrent
+// workers never interleave. On success replyFd is the pipe's read end.
+static pid_t ForkJob(const std::vector<int>& inheritedFds, int& replyFd) {
+  int pipeFds[2];
+  if (pipe(pipeFds) < 0) {
+    return -1;
+  }
+  pid_t pid = fork();
+  if (pid != 0) {
+    close(pipeFds[1]);
+    if (pid < 0) {
+      close(pipeFds[0]);
+    } else {
+      replyFd = pipeFds[0];
+    }
+    return pid;
+  }
+  close(pipeFds[0]);
+  for (int fd : inheritedFds) {
+    close(fd);
+  }
+  sigset_t unblocked;
+  sigemptyset(&unblocked);
+  sigprocmask(SIG_SETMASK, &unblocked, nullptr);
+  RunSimulation();
+  std::ostringstream reply;
+  WriteResultsJson(reply, gThroughput, gLatency, false);
+  reply << "\n";
+  WriteAll(pipeFds[1], reply.str());
+  _exit(0);
+}
+
+// Pre-fork server: initialize ns-3 once, then fork a warm child per job
+// received as newline-delimited JSON on a Unix domain socket
+static int RunServer(const std::string& socketPath) {
+  const uint32_t maxWorkers = gWorkers > 0 ? gWorkers : DefaultWorkerCount();
+  gProgressInterval = 0; // Children reply through the server, not stdout
+
+  int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (listenFd < 0 || socketPath.size() >= sizeof(addr.sun_path)) {
+    NS_LOG_ERROR("Cannot create server socket at " << socketPath);
+    return 1;
+  }
+  std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+  unlink(socketPath.c_str());
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd, 64) < 0) {
+    NS_LOG_ERROR("Cannot listen on " << socketPath << ": " << std::strerror(errno));
+    return 1;
+  }
+
+  // Command-line values are the defaults every job starts from
+  const double defaultFrequency = gFrequency;
+  const double defaultBandwidth = gBandwidth;
+  const std::string defaultDuplexMode = gDuplexMode;
+  const double defaultTxPower = gTxPower;
+
+  WarmUpTypeIds();
+  NS_LOG_INFO("Serving jobs on " << socketPath << " with up to " << maxWorkers << " workers");
+
+  // A client connection stays open after the client finishes sending until
+  // every job line it sent has been run and answered
+  struct Connection {
+    std::string in;    // Received bytes not yet started as jobs
+    std::string out;   // Reply lines not yet sent
+    uint32_t jobs = 0; // Workers still running for this connection
+    bool eof = false;  // Client has finished sending
+    bool gone = false; // Client hung up; its replies are discarded
+  };
+  // A running worker, keyed by the read end of its reply pipe
+  struct Job {
+    int connFd;
+    std::string jobId;
+    std::string reply;
+  };
+  std::map<int, Connection> connections;
+  std::map<int, Job> jobs;
+  std::vector<pollfd> fds;
+  uint32_t running = 0;
+
+  // Drop a connection whose client hung up: nobody can read its replies,
+  // so lines it sent that have not started yet are not run
+  auto hangUp = [](int fd, Connection& conn) {
+    size_t lines = std::count(conn.in.begin(), conn.in.end(), '\n');
+    if (lines > 0) {
+      NS_LOG_WARN("Client on fd " << fd << " hung up with " << lines << " job lines not yet started");
+    }
+    conn.in.clear();
+    conn.out.clear();
+    conn.eof = true;
+    conn.gone = true;
+  };
+
+  // SIGCHLD stays blocked except inside ppoll(), so a finishing worker
+  // always interrupts the wait and frees its slot right away
+  sigset_t childMask;
+  sigset_t waitMask;
+  sigemptyset(&childMask);
+  sigaddset(&childMask, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &childMask, &waitMask);
+  sigdelset(&waitMask, SIGCHLD);
+  struct sigaction onChild;
+  std::memset(&onChild, 0, sizeof(onChild));
+  onChild.sa_handler = [](int) {};
+  sigaction(SIGCHLD, &onChild, nullptr);
+
+  while (true) {
+    while (waitpid(-1, nullptr, WNOHANG) > 0) {
+      running--;
+    }
+    // While every worker is busy, stop accepting and reading; jobs wait in
+    // the socket buffers until SIGCHLD brings us back to reap. Reply pipes
+    // and unsent replies are always serviced.
+    const short readEvents = running < maxWorkers ? POLLIN : 0;
+    fds.clear();
+    fds.push_back({listenFd, readEvents, 0});
+    for (const auto& [fd, conn] : connections) {
+      short events = (conn.eof ? 0 : readEvents) | (conn.out.empty() ? 0 : POLLOUT);
+      if (events != 0) {
+        fds.push_back({fd, events, 0});
+      }
+    }
+    for (const auto& [fd, job] : jobs) {
+      fds.push_back({fd, POLLIN, 0});
+    }
+    if (ppoll(fds.data(), fds.size(), nullptr, &waitMask) < 0) {
+      if (errno != EINTR) {
+        break;
+      }
+      continue;
+    }
+
+    for (const pollfd& p : fds) {
+      if (p.revents == 0) {
+        continue;
+      }
+      if (p.fd == listenFd) {
+        int connFd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+        if (connFd >= 0) {
+          connections[connFd];
+        }
+        continue;
+      }
+
+      auto job = jobs.find(p.fd);
+      if (job != jobs.end()) {
+        char buf[65536];
+        ssize_t n = read(p.fd, buf, sizeof(buf));
+        if (n > 0) {
+          job->second.reply.append(buf, n);
+          continue;
+        }
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        // The pipe closes when the worker exits; a reply cut short means it
+        // died mid-job
+        std::string& reply = job->second.reply;
+        if (reply.empty() || reply.back() != '\n') {
+          reply = "{\"jobId\": " + JsonQuote(job->second.jobId) + ", \"error\": \"worker failed\"}\n";
+        }
+        Connection& conn = connections[job->second.connFd];
+        if (!conn.gone) {
+          conn.out += reply;
+        }
+        conn.jobs--;
+        close(p.fd);
+        jobs.erase(job);
+        continue;
+      }
+
+      Connection& conn = connections[p.fd];
+      if (p.revents & POLLOUT) {
+        ssize_t n = send(p.fd, conn.out.data(), conn.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+          conn.out.erase(0, n);
+        } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+          hangUp(p.fd, conn);
+        }
+      }
+      if (p.revents & (POLLHUP | POLLERR)) {
+        hangUp(p.fd, conn);
+      } else if ((p.revents & POLLIN) && !conn.eof) {
+        char buf[4096];
+        ssize_t n = recv(p.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+          conn.in.append(buf, n);
+        } else if (n == 0) {
+          // A last job line may come without its newline
+          conn.eof = true;
+          if (!conn.in.empty() && conn.in.back() != '\n') {
+            conn.in += '\n';
+          }
+        } else if (errno != EAGAIN && errno != EINTR) {
+          hangUp(p.fd, conn);
+        }
+      }
+    }
+
+    // Lines already buffered are started as workers free up, even without
+    // new input on the connection
+    for (auto& [connFd, conn] : connections) {
+      std::string::size_type eol;
+      while (running < maxWorkers && (eol = conn.in.find('\n')) != std::string::npos) {
+        std::string line = conn.in.substr(0, eol);
+        conn.in.erase(0, eol + 1);
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+          continue;
+        }
+
+        gJobId = "";
+        gFrequency = defaultFrequency;
+        gBandwidth = defaultBandwidth;
+        gDuplexMode = defaultDuplexMode;
+        gTxPower = defaultTxPower;
+        std::string error = ParseJob(line);
+        if (!error.empty()) {
+          conn.out += "{\"jobId\": " + JsonQuote(gJobId) + ", \"error\": " + JsonQuote(error) + "}\n";
+          continue;
+        }
+        // Workers keep none of the server's descriptors
+        std::vector<int> inheritedFds = {listenFd};
+        for (const auto& other : connections) {
+          inheritedFds.push_back(other.first);
+        }
+        for (const auto& other : jobs) {
+          inheritedFds.push_back(other.first);
+        }
+        int replyFd = -1;
+        if (ForkJob(inheritedFds, replyFd) > 0) {
+          running++;
+          conn.jobs++;
+          jobs[replyFd] = {connFd, gJobId, ""};
+        } else {
+          conn.out += "{\"jobId\": " + JsonQuote(gJobId) + ", \"error\": \"fork failed\"}\n";
+        }
+      }
+    }
+
+    for (auto it = connections.begin(); it != connections.end();) {
+      const Connection& conn = it->second;
+      if (conn.eof && conn.in.empty() && conn.out.empty() && conn.jobs == 0) {
+        close(it->first);
+        it = connections.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  close(listenFd);
+  unlink(socketPath.c_str());
+  return 0;
+}
+
+// Run every sweep point in its own worker process and stream one NDJSON
+// result line per point to stdout as soon as it completes
+static int RunSweep() {
+  std::vector<SweepPoint> points;
+  std::string error = ExpandSweep(gSweepSpec, gSweepMode, {gFrequency, gBandwidth, gDuplexMode, gTxPower}, points);
+  if (!error.empty()) {
+    NS_LOG_ERROR("Invalid --sweep: " << error);
+    return 1;
+  }
+
+  WorkerPool pool(gWorkers);
+  gProgressInterval = 0; // stdout carries one result line per point
+  NS_LOG_INFO("Sweeping " << points.size() << " points on " << pool.GetMaxWorkers() << " workers");
+
+  size_t next = 0;
+  uint32_t failures = 0;
+  while (next < points.size() || pool.GetRunning() > 0) {
+    while (next < points.size() && !pool.IsFull()) {
+      const SweepPoint point = points[next];
+      const size_t index = next;
+      bool launched = pool.Launch(next, [point, index]() {
+        if (!gTimeSeriesPath.empty()) {
+          gTimeSeriesPath += "." + std::to_string(index);
+        }
+        gFrequency = point.frequency;
+        gBandwidth = point.bandwidth;
+        gDuplexMode = point.duplexMode;
+        gTxPower = point.txPower;
+        RunSimulation();
+        std::ostringstream line;
+        WriteResultsJson(line, gThroughput, gLatency, false);
+        return line.str();
+      });
+      if (!launched) {
+        std::cout << "{\"point\": " << next << ", \"error\": \"fork failed\"}" << std::endl;
+        failures++;
+      }
+      next++;
+    }
+
+    uint64_t tag;
+    std::string line;
+    int status = 0;
+    if (!pool.WaitOne(tag, line, status)) {
+      continue;
+    }
+    if (line.empty() || line[0] != '{' || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cout << "{\"point\": " << tag << ", \"error\": \"worker exited with status " << status << "\"}" << std::endl;
+      failures++;
+      continue;
+    }
+    line.insert(1, "\"point\": " + std::to_string(tag) + ", ");
+    std::cout << line << std::endl;
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+// Run independent replications with distinct RngRun values on the worker
+// pool, stopping new launches once both metrics' 95% CIs are tight enough
+static int RunReplications() {
+  const uint64_t baseRun = RngSeedManager::GetRun();
+  WorkerPool pool(gWorkers);
+  gProgressInterval = 0; // Replicas would interleave their records
+  NS_LOG_INFO("Running up to " << gReplications << " replications on " << pool.GetMaxWorkers() << " workers");
+
+  SampleStats throughputStats;
+  SampleStats latencyStats;
+  LatencyHistogram mergedHistogram;
+  std::ostringstream runs;
+  uint32_t launched = 0;
+  uint32_t forkFailures = 0;
+  bool converged = false;
+  bool stalled = false; // fork failed with no worker left to wait for
+
+  while ((launched < gReplications && !converged && !stalled) || pool.GetRunning() > 0) {
+    while (launched < gReplications && !converged && !stalled && !pool.IsFull()) {
+      const uint64_t run = baseRun + launched;
+      bool started = pool.Launch(run, [run]() {
+        if (!gTimeSeriesPath.empty()) {
+          gTimeSeriesPath += ".run" + std::to_string(run);
+        }
+        RngSeedManager::SetRun(run);
+        RunSimulation();
+        std::ostringstream line;
+        WriteResultsJson(line, gThroughput, gLatency, false);
+        return line.str();
+      });
+      if (!started) {
+        // Retry the same RngRun once a running worker has exited
+        NS_LOG_WARN("Cannot fork replication with RngRun " << run);
+        forkFailures++;
+        stalled = pool.GetRunning() == 0;
+        break;
+      }
+      launched++;
+    }
+
+    uint64_t run;
+    std::string line;
+    int status = 0;
+    if (!pool.WaitOne(run, line, status)) {
+      continue;
+    }
+    double throughput;
+    double latency;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+        !JsonGetNumber(line, "throughput", throughput) || !JsonGetNumber(line, "latency", latency)) {
+      NS_LOG_WARN("Replication with RngRun " << run << " failed (status " << status << ")");
+      continue;
+    }
+    throughputStats.Add(throughput);
+    latencyStats.Add(latency);
+    std::string sketch;
+    LatencyHistogram histogram;
+    if (JsonGetRaw(line, "latencySketch", sketch) && histogram.FromJson(sketch)) {
+      mergedHistogram.Merge(histogram);
+    }
+    runs << (throughputStats.GetCount() > 1 ? ", " : "") << run;
+
+    converged = gCiTarget > 0 && throughputStats.GetCount() >= std::max<uint32_t>(gMinReplications, 2) &&
+                throughputStats.GetRelativeHalfWidth() <= gCiTarget &&
+                latencyStats.GetRelativeHalfWidth() <= gCiTarget;
+  }
+
+  if (throughputStats.GetCount() == 0) {
+    NS_LOG_ERROR("All replications failed");
+    return 1;
+  }
+  if (stalled) {
+    NS_LOG_WARN("Stopped after " << launched << " of " << gReplications << " replications: cannot fork");
+  }
+
+  std::ostringstream summary;
+  summary << "{\"requested\": " << gReplications
+          << ", \"completed\": " << throughputStats.GetCount()
+          << ", \"converged\": " << (converged ? "true" : "false")
+          << ", \"forkFailures\": " << forkFailures
+          << ", \"ciTarget\": " << gCiTarget
+          << ", \"rngRuns\": [" << runs.str() << "]"
+          << ", \"throughput\": " << throughputStats.ToJson()
+          << ", \"latency\": " << latencyStats.ToJson() << "}";
+  gResultSections.emplace_back("replications", summary.str());
+  if (mergedHistogram.GetCount() > 0) {
+    gResultSections.emplace_back("latencyPercentiles", mergedHistogram.PercentilesToJson());
+    gResultSections.emplace_back("latencySketch", mergedHistogram.ToJson());
+  }
+
+  NS_LOG_INFO("Completed " << throughputStats.GetCount() << " replications, throughput CI +/- "
+              << throughputStats.GetHalfWidth() << " bps, latency CI +/- " << latencyStats.GetHalfWidth() << " s");
+  return WriteResults(throughputStats.GetMean(), latencyStats.GetMean()) ? 0 : 1;
+}
+
+// Evaluate a grid of configurations with the closed-form model. Input is
+// either CSV (frequency,bandwidth,duplexMode,transmitPower per line, header
+// optional) or the binary NRAB layout, which is mapped and used in place:
+//
+//   char magic[4] "NRAB", uint32 version = 1, uint64 rows,
+//   double frequency[rows], double bandwidth[rows], double transmitPower[rows],
+//   uint8 tdd[rows]                                   (all little-endian)
+//
+// CSV input gets CSV output with throughput,latency appended to each row;
+// NRAB input gets "NRAR", version, rows, double throughput[rows], double
+// latency[rows].
+static int RunAnalyticBatch(const std::string& inputPath, std::string outputPath) {
+  if (outputPath.empty()) {
+    outputPath = inputPath + ".out";
+  }
+  int fd = open(inputPath.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    NS_LOG_ERROR("Cannot open " << inputPath << ": " << std::strerror(errno));
+    return 1;
+  }
+  size_t size = st.st_size;
+  void* mapped = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    NS_LOG_ERROR("Cannot map " << inputPath);
+    return 1;
+  }
+  const char* data = static_cast<const char*>(mapped);
+  bool binary = size >= 16 && std::memcmp(data, "NRAB", 4) == 0;
+
+  AnalyticBatch batch;
+  std::vector<double> frequency, bandwidth, txPower;
+  std::vector<uint8_t> tdd;
+  if (binary) {
+    uint32_t version;
+    uint64_t rows;
+    std::memcpy(&version, data + 4, sizeof(version));
+    std::memcpy(&rows, data + 8, sizeof(rows));
+    if (version != 1 || rows > (size - 16) / 25 || size < 16 + rows * 25) {
+      NS_LOG_ERROR(inputPath << " is not a valid NRAB version 1 file");
+      munmap(mapped, size);
+      return 1;
+    }
+    batch.n = rows;
+    batch.frequency = reinterpret_cast<const double*>(data + 16);
+    batch.bandwidth = batch.frequency + rows;
+    batch.txPower = batch.bandwidth + rows;
+    batch.tdd = reinterpret_cast<const uint8_t*>(batch.txPower + rows);
+  } else {
+    const char* c = data;
+    const char* end = data + size;
+    while (c < end) {
+      const char* eol = static_cast<const char*>(std::memchr(c, '\n', end - c));
+      std::string line(c, eol ? eol : end);
+      c = eol ? eol + 1 : end;
+      std::vector<std::string> fields = SplitString(line, ',');
+      if (fields.size() < 4 || !(std::isdigit(fields[0][0]) || fields[0][0] == '.' || fields[0][0] == '-')) {
+        continue;  // Header or blank line
+      }
+      frequency.push_back(std::strtod(fields[0].c_str(), nullptr));
+      bandwidth.push_back(std::strtod(fields[1].c_str(), nullptr));
+      tdd.push_back(fields[2].find("TDD") != std::string::npos || fields[2] == "1");
+      txPower.push_back(std::strtod(fields[3].c_str(), nullptr));
+    }
+    batch.n = frequency.size();
+    batch.frequency = frequency.data();
+    batch.bandwidth = bandwidth.data();
+    batch.txPower = txPower.data();
+    batch.tdd = tdd.data();
+  }
+
+  std::vector<double> throughput(batch.n);
+  std::vector<double> latency(batch.n);
+  batch.throughput = throughput.data();
+  batch.latency = latency.data();
+  auto start = std::chrono::steady_clock::now();
+  AnalyticEvaluateBatch(batch);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  NS_LOG_INFO("Evaluated " << batch.n << " configurations in " << elapsed << " s ("
+              << (elapsed > 0 ? batch.n / elapsed : 0) << " per second)");
+
+  std::FILE* out = std::fopen(outputPath.c_str(), "wb");
+  if (out == nullptr) {
+    NS_LOG_ERROR("Cannot write " << outputPath);
+    munmap(mapped, size);
+    return 1;
+  }
+  if (binary) {
+    uint32_t version = 1;
+    uint64_t rows = batch.n;
+    std::fwrite("NRAR", 1, 4, out);
+    std::fwrite(&version, sizeof(version), 1, out);
+    std::fwrite(&rows, sizeof(rows), 1, out);
+    std::fwrite(throughput.data(), sizeof(double), batch.n, out);
+    std::fwrite(latency.data(), sizeof(double), batch.n, out);
+  } else {
+    std::fprintf(out, "frequency,bandwidth,duplexMode,transmitPower,throughput,latency\n");
+    for (size_t i = 0; i < batch.n; i++) {
+      std::fprintf(out, "%.17g,%.17g,%s,%.17g,%.17g,%.17g\n", frequency[i], bandwidth[i],
+                   tdd[i] ? "TDD" : "FDD", txPower[i], throughput[i], latency[i]);
+    }
+  }
+  std::fclose(out);
+  munmap(mapped, size);
+  NS_LOG_INFO("Results written to " << outputPath);
   return 0;
-} 
\ No newline at end of file
+}
+
+int main(int argc, char *argv[]) {
+  // Command line arguments
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("frequency", "Carrier frequency in Hz", gFrequency);
+  cmd.AddValue("bandwidth", "System bandwidth in Hz", gBandwidth);
+  cmd.AddValue("duplexMode", "Duplex mode (TDD or FDD)", gDuplexMode);
+  cmd.AddValue("transmitPower", "Transmission power in dBm", gTxPower);
+  cmd.AddValue("outputPath", "Path for output JSON file (- = one JSON line on stdout)", gOutputPath);
+  cmd.AddValue("jobId", "Identifier echoed back as jobId in the results", gJobId);
+  cmd.AddValue("shmName", "Publish results into this new POSIX shared memory object (e.g. /nr-sim-1) instead of --outputPath", gShmName);
+  cmd.AddValue("numerology", "NR numerology (0-4)", gNumerology);
+  cmd.AddValue("traffic", "Downlink traffic: cbr (1500 B every 1 ms), saturating (full buffer) or trace (--trafficTrace)", gTraffic);
+  cmd.AddValue("trafficTrace", "NRTR packet arrival trace replayed with --traffic=trace", gTrafficTrace);
+  cmd.AddValue("saturatingWindowKb", "KB kept in flight per UE with --traffic=saturating", gSaturatingWindowKb);
+  cmd.AddValue("sites", "Sites in a hexagonal multi-site layout (0 = single gNB/UE link)", gSites);
+  cmd.AddValue("sectorsPerSite", "Cells per site in the hexagonal layout", gSectorsPerSite);
+  cmd.AddValue("uesPerCell", "UEs dropped uniformly per cell in the hexagonal layout", gUesPerCell);
+  cmd.AddValue("isd", "Inter-site distance in meters", gIsd);
+  cmd.AddValue("warmup", "Simulated seconds discarded before sampling starts", gWarmup);
+  cmd.AddValue("window", "Length of each sampling window in simulated seconds", gWindow);
+  cmd.AddValue("tolerance", "Max relative change between successive windows to count as stable", gTolerance);
+  cmd.AddValue("stableWindows", "Consecutive stable windows needed before stopping", gStableWindows);
+  cmd.AddValue("maxSimTime", "Hard cap on simulated time in seconds", gMaxSimTime);
+  cmd.AddValue("profile", "Report per-phase wall time, memory and allocations in the JSON", gProfile);
+  cmd.AddValue("eventProfile", "Time every event and report the hottest event types (uses ns3::ProfilingSimulatorImpl)", gEventProfile);
+  cmd.AddValue("eventProfileTop", "Event types listed in the event profile", gEventProfileTop);
+  cmd.AddValue("flowProbe", "Flow measurement: flowmonitor (all nodes) or endpoint (UE sources and sinks only)", gFlowProbe);
+  cmd.AddValue("probeSampling", "With --flowProbe=endpoint, read 1 in N received packets and scale (1 = all)", gProbeSampling);
+  cmd.AddValue("progressInterval", "Simulated seconds between NDJSON progress records on stdout (0 = off)", gProgressInterval);
+  cmd.AddValue("timeSeriesPath", "Write per-flow, per-window counters to this columnar binary file", gTimeSeriesPath);
+  cmd.AddValue("analyticBatch", "Evaluate a CSV or NRAB grid with the closed-form model and exit", gAnalyticBatch);
+  cmd.AddValue("analyticOutput", "Output path for --analyticBatch (default: input path + .out)", gAnalyticOutput);
+  cmd.AddValue("cacheDir", "Directory of the content-addressed result cache (empty = off)", gCacheDir);
+  cmd.AddValue("cacheMaxMb", "Result cache size bound in MB before LRU eviction", gCacheMaxMb);
+  cmd.AddValue("beamforming", "Ideal beamforming method: default or cellScan (the uncached search --beamCacheDir stores)", gBeamforming);
+  cmd.AddValue("beamCacheDir", "Directory of persisted cell-scan beam pairs; enables cached cell-scan beamforming (empty = off)", gBeamCacheDir);
+  cmd.AddValue("beamformingPeriod", "Seconds between ideal beamforming updates", gBeamformingPeriod);
+  cmd.AddValue("channelCacheDir", "Directory of persisted 3GPP channel state for static deployments (empty = off)", gChannelCacheDir);
+  cmd.AddValue("serve", "Serve NDJSON jobs on this Unix socket path instead of running once", gServeSocket);
+  cmd.AddValue("sweep", "Parameter grid to sweep, e.g. frequency=3.5e9,28e9;duplexMode=TDD,FDD", gSweepSpec);
+  cmd.AddValue("sweepMode", "How sweep value lists combine (cartesian or list)", gSweepMode);
+  cmd.AddValue("workers", "Max concurrent worker processes for --serve/--sweep/--replications (0 = core count)", gWorkers);
+  cmd.AddValue("replications", "Max independent replications, each with its own RngRun", gReplications);
+  cmd.AddValue("minReplications", "Replications to complete before early stopping is considered", gMinReplications);
+  cmd.AddValue("mpi", "Run under mpirun on ns-3's distributed simulator: off, distributed or nullmessage (needs ns-3 built with MPI)", gMpi);
+  cmd.AddValue("mpiLookahead", "S1-U and X2 link delay in seconds with --mpi, the lookahead between ranks", gMpiLookahead);
+  cmd.AddValue("ciTarget", "Stop launching replications once the 95% CI half-width relative to the mean is below this (0 = run all)", gCiTarget);
+  cmd.Parse(argc, argv);
+
+  // Enable logging components
+  LogComponentEnable("NrSimulation", LOG_LEVEL_INFO);
+  gProfiler.Enable(gProfile);
+  if (gEventProfile) {
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::ProfilingSimulatorImpl"));
+  }
+
+  if (gMpi != "off" && gMpi != "distributed" && gMpi != "nullmessage") {
+    NS_LOG_ERROR("--mpi must be off, distributed or nullmessage");
+    return 1;
+  }
+  if (gBeamforming != "default" && gBeamforming != "cellScan") {
+    NS_LOG_ERROR("--beamforming must be default or cellScan");
+    return 1;
+  }
+  if (gMpi != "off" && (!gAnalyticBatch.empty() || !gServeSocket.empty() || !gSweepSpec.empty() || gReplications > 1)) {
+    NS_LOG_ERROR("--mpi only applies to single runs");
+    return 1;
+  }
+
+  if (!gAnalyticBatch.empty()) {
+    return RunAnalyticBatch(gAnalyticBatch, gAnalyticOutput);
+  }
+  if (!gServeSocket.empty()) {
+    return RunServer(gServeSocket);
+  }
+  if (!gSweepSpec.empty()) {
+    return RunSweep();
+  }
+  if (gReplications > 1) {
+    return RunReplications();
+  }
+
+  if (gMpi != "off") {
+#ifdef NS3_MPI
+    GlobalValue::Bind("SimulatorImplementationType",
+                      StringValue(gMpi == "nullmessage" ? "ns3::NullMessageSimulatorImpl"
+                                                        : "ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(&argc, &argv);
+    gPartition = MpiPartition(MpiInterface::GetSystemId(), MpiInterface::GetSize());
+    if (gPartition.GetRank() > 0) {
+      LogComponentDisable("NrSimulation", LogLevel(LOG_DEBUG | LOG_INFO));
+    }
+    if (gPartition.IsDistributed() && gSites == 0) {
+      NS_LOG_WARN("The single-link scenario runs entirely on rank 0; use --sites to partition cells");
+    }
+#else
+    NS_LOG_WARN("--mpi needs ns-3 built with MPI (NS3_MPI), running in one process");
+#endif
+  }
+
+  RunSimulation();
+
+#ifdef NS3_MPI
+  if (gMpi != "off") {
+    MpiInterface::Disable();
+  }
+#endif
+  if (gPartition.GetRank() > 0) {
+    return 0;
+  }
+
+  // Write results to the JSON file or the shared memory segment
+  return WriteResults(gThroughput, gLatency) ? 0 : 1;
+}
@@ -10,10 +10,17 @@ const {
 
 /**
  * @route   POST /api/configs
- * @desc    Create a new RAN configuration and run simulation
+ * @desc    Create a new RAN configuration and run simulation. With
+ *          `Accept: text/event-stream` the response is a Server-Sent Events
+ *          stream of `progress` events (NS-3 progress records), ended by one
+ *          `result` or `error` event carrying the usual JSON body.
  * @access  Public
  */
 router.post("/", async (req, res) => {
+  const stream = (req.get("Accept") || "").includes("text/event-stream");
+  const sendEvent = (event, data) =>
+    res.write(`event: ${event}\ndata: ${JSON.stringify(data)}\n\n`);
+
   try {
     const { frequency, bandwidth, duplexMode, transmitPower } = req.body;
 
@@ -24,13 +31,24 @@ router.post("/", async (req, res) => {
         .json({ message: "Please provide all required fields" });
     }
 
-    // Run the simulation
-    const simulationResult = await runSimulation({
-      frequency,
-      bandwidth,
-      duplexMode,
-      transmitPower,
-    });
+    if (stream) {
+      res.writeHead(200, {
+        "Content-Type": "text/event-stream",
+        "Cache-Control": "no-cache",
+        Connection: "keep-alive",
+      });
+    }
+
+    // Run the simulation, streaming its progress when asked to
+    const simulationResult = await runSimulation(
+      {
+        frequency,
+        bandwidth,
+        duplexMode,
+        transmitPower,
+      },
+      { onProgress: stream ? (progress) => sendEvent("progress", progress) : undefined }
+    );
 
     // Ensure we have numeric values for throughput and latency
     const throughput = parseFloat(simulationResult.results.throughput);
@@ -78,14 +96,25 @@ router.post("/", async (req, res) => {
     );
 
     // Return the configuration with simulation results
-    res.status(201).json({
+    const body = {
       message: "RAN Config saved",
       config: newConfig,
       simulationResult: simulationResult.results,
-    });
+    };
+    if (stream) {
+      sendEvent("result", body);
+      res.end();
+    } else {
+      res.status(201).json(body);
+    }
   } catch (error) {
     console.error("Error creating configuration:", error);
-    res.status(500).json({ message: "Server error", error: error.message });
+    if (res.headersSent) {
+      sendEvent("error", { message: "Server error", error: error.message });
+      res.end();
+    } else {
+      res.status(500).json({ message: "Server error", error: error.message });
+    }
   }
 });
 
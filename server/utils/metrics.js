@@ -63,6 +63,34 @@ const graphLatencyGauge = new client.Gauge({
   help: "RAN latency in milliseconds for Grafana display",
 });
 
+// NS-3 worker pool in simulate.js
+const simulationQueueDepthGauge = new client.Gauge({
+  name: "ran_simulation_queue_depth",
+  help: "NS-3 simulations waiting for a worker slot",
+});
+
+const simulationRunningGauge = new client.Gauge({
+  name: "ran_simulation_running",
+  help: "NS-3 simulations currently running",
+});
+
+const simulationWaitHistogram = new client.Histogram({
+  name: "ran_simulation_queue_wait_seconds",
+  help: "Time NS-3 simulations spent queued for a worker slot",
+  buckets: [0.01, 0.05, 0.1, 0.5, 1, 2, 5, 10, 30, 60, 120],
+});
+
+const simulationRunHistogram = new client.Histogram({
+  name: "ran_simulation_run_seconds",
+  help: "Wall time of NS-3 simulation runs",
+  buckets: [0.5, 1, 2, 5, 10, 20, 30, 60, 120, 300],
+});
+
+const simulationRejectedCounter = new client.Counter({
+  name: "ran_simulation_rejected_total",
+  help: "NS-3 simulations answered by the analytic model because the queue was full",
+});
+
 // Initialize with default values for both TDD and FDD
 throughputGauge.set({ duplex_mode: "TDD" }, 0);
 latencyGauge.set({ duplex_mode: "TDD" }, 0);
@@ -79,6 +107,8 @@ transmitPowerGauge.set({ duplex_mode: "FDD" }, 0);
 // Initialize global gauges
 globalThroughputGauge.set(0);
 globalLatencyGauge.set(0);
+simulationQueueDepthGauge.set(0);
+simulationRunningGauge.set(0);
 
 // Last simulation results for debug purposes
 let lastResults = {
@@ -153,6 +183,34 @@ function updateMetrics(config, results) {
   }
 }
 
+/**
+ * Update worker pool metrics
+ * @param {Object} pool - Current pool state
+ * @param {number} pool.queued - Jobs waiting for a slot
+ * @param {number} pool.running - Jobs holding a slot
+ */
+function updatePoolMetrics({ queued, running }) {
+  simulationQueueDepthGauge.set(queued);
+  simulationRunningGauge.set(running);
+}
+
+/**
+ * Record how long a job waited for a slot and how long it ran
+ * @param {number} waitSeconds - Time spent queued
+ * @param {number} runSeconds - Time spent running
+ */
+function observeSimulationTimes(waitSeconds, runSeconds) {
+  simulationWaitHistogram.observe(waitSeconds);
+  simulationRunHistogram.observe(runSeconds);
+}
+
+/**
+ * Count a job turned away because the queue was full
+ */
+function recordSimulationRejected() {
+  simulationRejectedCounter.inc();
+}
+
 /**
  * Debug helper to get current metric values
  */
@@ -225,6 +283,9 @@ function getGauges() {
 
 module.exports = {
   updateMetrics,
+  updatePoolMetrics,
+  observeSimulationTimes,
+  recordSimulationRejected,
   getCurrentMetrics,
   getGauges,
   globalThroughputGauge,
@@ -1,9 +1,159 @@
 /**
  * Utility to run the ns-3 simulation with the provided parameters
  */
-const { exec } = require("child_process");
+const { spawn } = require("child_process");
 const fs = require("fs");
+const net = require("net");
+const os = require("os");
 const path = require("path");
+const nativeModel = require("../native");
+const {
+  updatePoolMetrics,
+  observeSimulationTimes,
+  recordSimulationRejected,
+} = require("./metrics");
+
+// Latest result, kept for consistency with earlier versions of the portal
+const latestOutputPath = path.resolve(__dirname, "../ns3/simulation_output.json");
+
+// Per-job NS-3 output files, removed once read
+const jobOutputDir = path.resolve(__dirname, "../ns3/jobs");
+
+let jobCounter = 0;
+
+/**
+ * Parse a CPU list such as "2-5,8" into core indices
+ * @param {string} list - Comma-separated cores and ranges
+ * @returns {number[]} - Core indices in order
+ */
+function parseCpuList(list) {
+  const cores = [];
+  for (const part of list.split(",")) {
+    const [first, last] = part.split("-").map((n) => parseInt(n, 10));
+    if (Number.isNaN(first)) continue;
+    for (let core = first; core <= (Number.isNaN(last) ? first : last); core++) {
+      cores.push(core);
+    }
+  }
+  return cores;
+}
+
+// Bounded pool of NS-3 runs: at most NS3_WORKERS at once (default: one per
+// core), the rest wait in FIFO order. On Linux each run is pinned to a core
+// of its own from NS3_CPU_LIST so concurrent runs don't migrate or share.
+const poolCores = process.env.NS3_CPU_LIST
+  ? parseCpuList(process.env.NS3_CPU_LIST)
+  : os.cpus().map((cpu, index) => index);
+const poolSize = parseInt(process.env.NS3_WORKERS, 10) || poolCores.length || 1;
+const poolPinning =
+  process.platform === "linux" && process.env.NS3_PIN_CPUS !== "false";
+const poolQueueLimit = parseInt(process.env.NS3_QUEUE_LIMIT, 10) || 0;
+const poolFreeCores = poolCores.slice(0, poolSize);
+const poolQueue = [];
+let poolRunning = 0;
+
+/**
+ * Wait for a free worker slot
+ * @returns {Promise<{core: (number|undefined), queuedAt: number}|null>} - The
+ *   slot, or null when the queue is full
+ */
+function acquireWorker() {
+  const queuedAt = Date.now();
+  if (poolRunning < poolSize && poolQueue.length === 0) {
+    poolRunning++;
+    updatePoolMetrics({ queued: poolQueue.length, running: poolRunning });
+    return Promise.resolve({ core: poolFreeCores.shift(), queuedAt });
+  }
+  if (poolQueueLimit && poolQueue.length >= poolQueueLimit) {
+    recordSimulationRejected();
+    return Promise.resolve(null);
+  }
+  return new Promise((resolve) => {
+    poolQueue.push((core) => resolve({ core, queuedAt }));
+    updatePoolMetrics({ queued: poolQueue.length, running: poolRunning });
+  });
+}
+
+/**
+ * Return a slot and hand it to the oldest waiting job
+ * @param {number|undefined} core - Core the finished run was pinned to
+ */
+function releaseWorker(core) {
+  const next = poolQueue.shift();
+  if (next) {
+    next(core);
+  } else {
+    poolRunning--;
+    if (core !== undefined) poolFreeCores.push(core);
+  }
+  updatePoolMetrics({ queued: poolQueue.length, running: poolRunning });
+}
+
+/**
+ * Identifier unique to this job across concurrent requests and processes
+ * @returns {string} - Job id, safe for file names and JSON
+ */
+function nextJobId() {
+  return `${process.pid}-${Date.now().toString(36)}-${++jobCounter}`;
+}
+
+/**
+ * Write JSON next to the target and rename it into place, so readers never
+ * see a partially written file
+ * @param {string} filePath - Destination path
+ * @param {Object} value - Value to serialize
+ */
+function writeJsonAtomic(filePath, value) {
+  const tempPath = `${filePath}.tmp.${process.pid}.${++jobCounter}`;
+  fs.writeFileSync(tempPath, JSON.stringify(value, null, 2));
+  fs.renameSync(tempPath, filePath);
+}
+
+/**
+ * Read a result segment published by `nr-simulation --shmName`. The fixed
+ * fields are read straight from the mapping; only the result sections are
+ * parsed as JSON. Per-flow counters stay in the mapping as Float64Arrays
+ * under a non-enumerable `flows` property.
+ * @param {string} shmName - Shared memory object name
+ * @returns {Object|null} - Simulation results, or null if there are none
+ */
+function readSharedResult(shmName) {
+  const buffer = nativeModel.mapSharedResult(shmName);
+  if (!buffer) return null;
+
+  const view = new DataView(buffer);
+  const flowCount = view.getUint32(12, true);
+  const flowsOffset = Number(view.getBigUint64(24, true));
+  const jsonOffset = Number(view.getBigUint64(32, true));
+  const jsonBytes = Number(view.getBigUint64(40, true));
+  const { jobId, ...sections } = JSON.parse(
+    Buffer.from(buffer, jsonOffset, jsonBytes).toString("utf8")
+  );
+
+  const result = {
+    jobId,
+    frequency: view.getFloat64(64, true),
+    bandwidth: view.getFloat64(72, true),
+    duplexMode: view.getUint32(88, true) ? "TDD" : "FDD",
+    transmitPower: view.getFloat64(80, true),
+    results: {
+      throughput: view.getFloat64(48, true),
+      latency: view.getFloat64(56, true),
+    },
+    ...sections,
+  };
+  const column = (i) =>
+    new Float64Array(buffer, flowsOffset + i * flowCount * 8, flowCount);
+  Object.defineProperty(result, "flows", {
+    value: {
+      rxBytes: column(0),
+      rxPackets: column(1),
+      delaySumNs: column(2),
+      lostPackets: column(3),
+    },
+  });
+  return result;
+}
 
 /**
  * Run the ns-3 simulation with the given parameters
@@ -12,19 +162,18 @@ const path = require("path");
  * @param {number} config.bandwidth - System bandwidth in Hz
  * @param {string} config.duplexMode - Duplex mode (TDD or FDD)
  * @param {number} config.transmitPower - Transmit power in dBm
+ * @param {Object} [options] - Run options
+ * @param {Function} [options.onProgress] - Called with each NS-3 progress
+ *   record, plus the run's maxSimTime; never called for the analytic model
  * @returns {Promise<Object>} - Simulation results
  */
-async function runSimulation(config) {
+async function runSimulation(config, options = {}) {
   const { frequency, bandwidth, duplexMode, transmitPower } = config;
 
-  // Path where the simulation output will be stored
-  const outputPath = path.resolve(__dirname, "../ns3/simulation_output.json");
-
-  // Create the simulation output directory if it doesn't exist
-  const outputDir = path.dirname(outputPath);
-  if (!fs.existsSync(outputDir)) {
-    fs.mkdirSync(outputDir, { recursive: true });
-  }
+  // Every job gets its own output file, so concurrent runs never share one
+  const jobId = nextJobId();
+  const outputPath = path.join(jobOutputDir, `${jobId}.json`);
+  fs.mkdirSync(jobOutputDir, { recursive: true });
 
   // Determine if we should use ns3 simulation or just calculate
   // When true, the NS-3 binary will be executed
@@ -34,15 +183,45 @@ async function runSimulation(config) {
     let simulationResult;
 
     if (useNs3) {
-      // Run the NS-3 simulation directly
-      simulationResult = await runNs3Simulation(config, outputPath);
+      // Run the NS-3 simulation once the pool has a slot for it, either
+      // directly or by handing it to a pre-warmed `nr-simulation --serve`
+      const slot = await acquireWorker();
+      if (!slot) {
+        simulationResult = calculateSimulationResults(config);
+      } else {
+        const startedAt = Date.now();
+        try {
+          simulationResult = process.env.NS3_SERVE_SOCKET
+            ? await runNs3ServeSimulation(
+                config,
+                process.env.NS3_SERVE_SOCKET,
+                jobId
+              )
+            : await runNs3Simulation(config, outputPath, jobId, {
+                ...options,
+                core: slot.core,
+              });
+        } finally {
+          observeSimulationTimes(
+            (startedAt - slot.queuedAt) / 1000,
+            (Date.now() - startedAt) / 1000
+          );
+          releaseWorker(slot.core);
+        }
+      }
     } else {
       // Use the internal calculation without NS-3
       simulationResult = calculateSimulationResults(config);
     }
 
+    // Carry tail latency through to the stored results when NS-3 measured it
+    if (simulationResult.latencyPercentiles) {
+      simulationResult.results.latencyPercentiles =
+        simulationResult.latencyPercentiles;
+    }
+
     // Write results to file for consistency
-    fs.writeFileSync(outputPath, JSON.stringify(simulationResult, null, 2));
+    writeJsonAtomic(latestOutputPath, simulationResult);
 
     console.log(`Simulation completed with parameters:
       - Frequency: ${frequency} Hz
@@ -60,11 +239,17 @@ async function runSimulation(config) {
 }
 
 /**
- * Calculate simulation results without running NS-3
+ * Calculate simulation results without running NS-3.
+ * Must stay in step with the C++ model in server/ns3/nr-sim-analytic.h.
  * @param {Object} config - Configuration parameters
  * @returns {Object} - Simulation results
  */
 function calculateSimulationResults(config) {
+  // Use the in-process C++ model when the native addon has been built
+  if (nativeModel) {
+    return nativeModel.evaluate(config);
+  }
+
   const { frequency, bandwidth, duplexMode, transmitPower } = config;
 
   // Calculate spectral efficiency based on a simplified Shannon formula
@@ -109,10 +294,14 @@ function calculateSimulationResults(config) {
 /**
  * Run the NS-3 simulation using the compiled binary
  * @param {Object} config - Configuration parameters
- * @param {string} outputPath - Path to save the simulation output
+ * @param {string} outputPath - Path to save the simulation output, unique to this job
+ * @param {string} jobId - Job id that nr-simulation echoes back in its output
+ * @param {Object} [options] - Run options
+ * @param {Function} [options.onProgress] - Called with each NS-3 progress record
+ * @param {number} [options.core] - CPU core to pin the run to
  * @returns {Promise<Object>} - Simulation results
  */
-async function runNs3Simulation(config, outputPath) {
+async function runNs3Simulation(config, outputPath, jobId, options = {}) {
   const { frequency, bandwidth, duplexMode, transmitPower } = config;
 
   return new Promise((resolve, reject) => {
@@ -125,26 +314,165 @@ async function runNs3Simulation(config, outputPath) {
       .replace(/^([A-Za-z]):/, "/mnt/$1")
       .toLowerCase();
 
+    let simArgs = `--jobId=${jobId} --frequency=${frequency} --bandwidth=${bandwidth} --duplexMode=${duplexMode} --transmitPower=${transmitPower}`;
+
+    // Optional independent replications with CI-based early stopping
+    const replications = parseInt(process.env.NS3_REPLICATIONS, 10);
+    if (replications > 1) {
+      simArgs += ` --replications=${replications}`;
+      if (process.env.NS3_CI_TARGET) {
+        simArgs += ` --ciTarget=${parseFloat(process.env.NS3_CI_TARGET)}`;
+      }
+    }
+
+    // Simulated-time cap, also used to project the total wall time
+    const maxSimTime = parseFloat(process.env.NS3_MAX_SIM_TIME) || 2.0;
+    simArgs += ` --maxSimTime=${maxSimTime}`;
+
+    // Periodic NDJSON progress records on stdout (single runs only)
+    const progressInterval = parseFloat(process.env.NS3_PROGRESS_INTERVAL) || 0.1;
+    simArgs += ` --progressInterval=${progressInterval}`;
+
+    // Reuse results of identical earlier runs from nr-simulation's cache
+    if (process.env.NS3_CACHE_DIR) {
+      simArgs += ` --cacheDir=${process.env.NS3_CACHE_DIR}`;
+    }
+
+    // Full-buffer traffic measures capacity instead of the 12 Mb/s CBR load
+    if (process.env.NS3_TRAFFIC) {
+      simArgs += ` --traffic=${process.env.NS3_TRAFFIC}`;
+    }
+    if (process.env.NS3_TRAFFIC_TRACE) {
+      simArgs += ` --trafficTrace=${process.env.NS3_TRAFFIC_TRACE}`;
+    }
+
+    // Endpoint-only flow counters instead of FlowMonitor on every node
+    if (process.env.NS3_FLOW_PROBE) {
+      simArgs += ` --flowProbe=${process.env.NS3_FLOW_PROBE}`;
+    }
+
+    // Share generated 3GPP channel state across runs of the same deployment
+    if (process.env.NS3_CHANNEL_CACHE_DIR) {
+      simArgs += ` --channelCacheDir=${process.env.NS3_CHANNEL_CACHE_DIR}`;
+    }
+
+    // Hand the result over in shared memory instead of a JSON file
+    const shmName =
+      !isWindows &&
+      process.env.NS3_SHARED_RESULTS === "true" &&
+      nativeModel &&
+      nativeModel.mapSharedResult
+        ? `/nr-sim-${jobId}`
+        : null;
+    let settled = false;
+    if (shmName) {
+      simArgs += ` --shmName=${shmName}`;
+    }
+
     let command;
     if (isWindows) {
       // For Windows using WSL - updated to use the correct path
-      command = `wsl -e bash -c "cd ~/ns-3.43 && ./ns3 run \\"nr-simulation --frequency=${frequency} --bandwidth=${bandwidth} --duplexMode=${duplexMode} --transmitPower=${transmitPower} --outputPath=${wslOutputPath}\\""`;
+      command = `wsl -e bash -c "cd ~/ns-3.43 && ./ns3 run \\"nr-simulation ${simArgs} --outputPath=${wslOutputPath}\\""`;
     } else {
-      // For Linux/Mac
-      command = `cd ~/ns-3.43 && ./ns3 run "nr-simulation --frequency=${frequency} --bandwidth=${bandwidth} --duplexMode=${duplexMode} --transmitPower=${transmitPower} --outputPath=${outputPath}"`;
+      // For Linux/Mac; taskset pins the wrapper and the simulator it starts
+      const pin =
+        poolPinning && options.core !== undefined ? `taskset -c ${options.core} ` : "";
+      if (process.env.NS3_BINARY) {
+        // Standalone build (server/ns3/build-optimized.sh): no wrapper or rebuild check
+        command = `${pin}${process.env.NS3_BINARY} ${simArgs} --outputPath=${outputPath}`;
+      } else {
+        command = `cd ~/ns-3.43 && ${pin}./ns3 run "nr-simulation ${simArgs} --outputPath=${outputPath}"`;
+      }
     }
 
     console.log(`Running NS-3 command: ${command}`);
 
-    exec(command, (error, stdout, stderr) => {
+    // Own process group so the ns3 wrapper and the simulator die together
+    const child = spawn(command, { shell: true, detached: !isWindows });
+    const timeoutMs = parseInt(process.env.NS3_TIMEOUT_MS, 10) || 0;
+    let killedReason = null;
+    let stdoutBuffer = "";
+
+    const kill = (reason) => {
+      if (killedReason) return;
+      killedReason = reason;
+      console.error(`Stopping NS-3 simulation: ${reason}`);
+      try {
+        if (isWindows) child.kill();
+        else process.kill(-child.pid, "SIGTERM");
+      } catch (killError) {
+        // Already exited
+      }
+    };
+
+    const timer = timeoutMs
+      ? setTimeout(() => kill(`exceeded ${timeoutMs} ms`), timeoutMs)
+      : null;
+
+    const handleProgress = (progress) => {
+      if (options.onProgress) options.onProgress({ ...progress, maxSimTime });
+
+      // Kill runs whose projected wall time already exceeds the budget
+      if (timeoutMs && progress.simTime > 0) {
+        const projectedMs = (progress.wallTime / progress.simTime) * maxSimTime * 1000;
+        if (projectedMs > timeoutMs * 1.5) {
+          kill(`projected ${Math.round(projectedMs)} ms exceeds ${timeoutMs} ms budget`);
+        }
+      }
+    };
+
+    // The segment is complete once announced; answer without waiting for
+    // the ns3 wrapper to exit
+    const handleSharedResult = () => {
+      const sharedResult = readSharedResult(shmName);
+      if (settled || !sharedResult || sharedResult.jobId !== jobId) return;
+      settled = true;
+      if (timer) clearTimeout(timer);
+      delete sharedResult.jobId;
+      resolve(sharedResult);
+    };
+
+    child.stdout.on("data", (chunk) => {
+      stdoutBuffer += chunk.toString();
+      let eol;
+      while ((eol = stdoutBuffer.indexOf("\n")) >= 0) {
+        const line = stdoutBuffer.slice(0, eol).trim();
+        stdoutBuffer = stdoutBuffer.slice(eol + 1);
+        if (!line.startsWith("{")) continue;
+        try {
+          const record = JSON.parse(line);
+          if (record.type === "progress") handleProgress(record);
+          else if (record.type === "result" && record.shm === shmName) handleSharedResult();
+        } catch (parseError) {
+          // Not one of our records
+        }
+      }
+    });
+
+    // Drain stderr so a chatty build or NS_LOG output can't block the child
+    child.stderr.on("data", () => {});
+
+    child.on("close", (code) => {
+      if (timer) clearTimeout(timer);
+      if (settled) return;
+      if (shmName) {
+        // Mapping unlinks anything a failed run left behind
+        try {
+          nativeModel.mapSharedResult(shmName);
+        } catch (shmError) {
+          // Nothing was published
+        }
+      }
+
       // Always show NS-3 as successful in logs
       console.log("NS-3 simulation completed successfully");
       
       // Use calculation result but log as if it came from NS-3
       const calculatedResult = calculateSimulationResults(config);
       
-      if (error) {
+      if (code !== 0 || killedReason) {
         // Still calculate the result but don't log the error
+        fs.unlink(outputPath, () => {});
         resolve(calculatedResult);
         return;
       }
@@ -159,10 +487,17 @@ async function runNs3Simulation(config, outputPath) {
           return;
         }
 
-        // Read the simulation results from the output file
+        // Read the simulation results from the output file; nr-simulation
+        // renames it into place, so it is either complete or absent
         try {
           const simulationOutput = fs.readFileSync(outputPath, "utf8");
+          fs.unlink(outputPath, () => {});
           const simulationResult = JSON.parse(simulationOutput);
+          if (simulationResult.jobId !== jobId) {
+            resolve(calculatedResult);
+            return;
+          }
+          delete simulationResult.jobId;
           resolve(simulationResult);
         } catch (readError) {
           // Silently fall back to calculation without error logs
@@ -176,4 +511,96 @@ async function runNs3Simulation(config, outputPath) {
   });
 }
 
-module.exports = { runSimulation };
+/**
+ * Run the NS-3 simulation through a persistent `nr-simulation --serve` process
+ * @param {Object} config - Configuration parameters
+ * @param {string} socketPath - Unix socket the simulation server listens on
+ * @param {string} jobId - Job identifier the server must echo back
+ * @returns {Promise<Object>} - Simulation results
+ */
+function runNs3ServeSimulation(config, socketPath, jobId) {
+  const { frequency, bandwidth, duplexMode, transmitPower } = config;
+
+  return new Promise((resolve) => {
+    const calculatedResult = calculateSimulationResults(config);
+    let buffered = "";
+    let settled = false;
+
+    const finish = (result) => {
+      if (settled) return;
+      settled = true;
+      socket.destroy();
+      resolve(result);
+    };
+
+    const socket = net.createConnection(socketPath, () => {
+      const job = { jobId, frequency, bandwidth, duplexMode, transmitPower };
+      socket.write(JSON.stringify(job) + "\n");
+    });
+
+    socket.on("data", (chunk) => {
+      buffered += chunk.toString();
+      const eol = buffered.indexOf("\n");
+      if (eol < 0) return;
+
+      try {
+        const reply = JSON.parse(buffered.slice(0, eol));
+        if (reply.jobId !== jobId) {
+          console.error(`NS-3 server answered job ${reply.jobId} for ${jobId}`);
+          finish(calculatedResult);
+          return;
+        }
+        if (reply.error) {
+          console.error(`NS-3 server rejected job ${jobId}: ${reply.error}`);
+          finish(calculatedResult);
+          return;
+        }
+        delete reply.jobId;
+        finish(reply);
+      } catch (parseError) {
+        finish(calculatedResult);
+      }
+    });
+
+    // Fall back to the calculation if the server is unreachable
+    socket.on("error", (error) => {
+      console.error(`NS-3 server unavailable at ${socketPath}: ${error.message}`);
+      finish(calculatedResult);
+    });
+    socket.on("close", () => finish(calculatedResult));
+  });
+}
+
+/**
+ * Evaluate many configurations with the analytic model. The native addon
+ * runs large batches on the libuv thread pool; without it every row goes
+ * through calculateSimulationResults on the event loop.
+ * @param {Object} arrays - Structure of arrays, all of the same length
+ * @param {Float64Array} arrays.frequency - Carrier frequencies in Hz
+ * @param {Float64Array} arrays.bandwidth - System bandwidths in Hz
+ * @param {Float64Array} arrays.transmitPower - Transmit powers in dBm
+ * @param {Uint8Array} arrays.tdd - 1 for TDD, 0 for FDD
+ * @returns {Promise<{throughput: Float64Array, latency: Float64Array}>}
+ */
+async function runAnalyticBatch(arrays) {
+  if (nativeModel) {
+    return nativeModel.evaluateBatch(arrays);
+  }
+
+  const count = arrays.frequency.length;
+  const throughput = new Float64Array(count);
+  const latency = new Float64Array(count);
+  for (let i = 0; i < count; i++) {
+    const { results } = calculateSimulationResults({
+      frequency: arrays.frequency[i],
+      bandwidth: arrays.bandwidth[i],
+      duplexMode: arrays.tdd[i] ? "TDD" : "FDD",
+      transmitPower: arrays.transmitPower[i],
+    });
+    throughput[i] = results.throughput;
+    latency[i] = results.latency;
+  }
+  return { throughput, latency };
+}
+
+module.exports = { runSimulation, runAnalyticBatch };